@@ -4,6 +4,8 @@
 #include <memory>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <shared_mutex>
 
 #include <boost/asio.hpp>
 #include <boost/archive/text_oarchive.hpp>
@@ -11,6 +13,7 @@
 
 #include "model.h"
 #include "serialization.h"
+#include "ticker.h"
 
 namespace app
 {
@@ -33,12 +36,18 @@ namespace app
                                               reserve_state_file_path{state_file_path + ".reserve"} {};
         ~Application() = default;
 
+        // Состояние сохраняется не чаще раза в period; при нулевом периоде - на каждом срабатывании тикера
         void SaveGameState(const std::chrono::milliseconds &delta_time)
         {
-            if (true)
+            since_save_ += delta_time;
+            if (since_save_ < period)
             {
-                SaveGame();
+                return;
             }
+
+            util::ScopedTimer timer{game_.ProfileOf(model::TickPhase::SAVE_STATE)};
+            since_save_ = std::chrono::milliseconds{0};
+            SaveGame();
         };
 
         void SaveGame()
@@ -61,6 +70,39 @@ namespace app
             std::filesystem::rename(reserve_state_file_path, state_file_path);
         }
 
+        // Удаляет игроков, чьи собаки ушли на покой в прошедших тиках
+        void RemoveRetiredPlayers()
+        {
+            players_.DeletePlayers(game_.TakeRetiredDogs());
+        }
+
+        // Запросы к отдельным сессиям берут общую блокировку и выполняются параллельно в strand своей сессии.
+        // Тик, вход в игру и остальные операции над всей игрой берут исключительную
+        std::shared_lock<std::shared_mutex> LockShared() const
+        {
+            // Турникет: пока исключительная блокировка ждёт, новые запросы её не обгоняют
+            {
+                std::lock_guard turnstile{turnstile_};
+            }
+            return std::shared_lock{state_mutex_};
+        }
+
+        std::unique_lock<std::shared_mutex> LockExclusive() const
+        {
+            std::lock_guard turnstile{turnstile_};
+            return std::unique_lock{state_mutex_};
+        }
+
+        TickStats &GetTickStats() noexcept
+        {
+            return tick_stats_;
+        }
+
+        const TickStats &GetTickStats() const noexcept
+        {
+            return tick_stats_;
+        }
+
         void RestoreGame()
         {
             if (state_file_path.empty())
@@ -97,6 +139,10 @@ namespace app
         const std::string state_file_path;
         const std::string reserve_state_file_path;
         std::chrono::milliseconds period{0};
+        std::chrono::milliseconds since_save_{0};
+        TickStats tick_stats_;
+        mutable std::shared_mutex state_mutex_;
+        mutable std::mutex turnstile_;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace util
+{
+    /*
+     *  Неизменяемый снимок, опубликованный через атомарно заменяемый shared_ptr (в духе RCU).
+     *  Писатель строит новый объект и подменяет указатель, читатели берут текущий снимок без блокировок
+     *  и держат его сколько нужно: старая версия живёт, пока на неё есть ссылки.
+     */
+    template <typename T>
+    class AtomicSnapshot
+    {
+    public:
+        AtomicSnapshot() = default;
+
+        explicit AtomicSnapshot(std::shared_ptr<const T> value)
+            : value_{std::move(value)}
+        {
+        }
+
+        // Копия публикует тот же снимок; нужно, чтобы владельцы оставались копируемыми
+        AtomicSnapshot(const AtomicSnapshot &other)
+            : value_{other.Load()}
+        {
+        }
+
+        AtomicSnapshot &operator=(const AtomicSnapshot &other)
+        {
+            Store(other.Load());
+            return *this;
+        }
+
+        std::shared_ptr<const T> Load() const noexcept
+        {
+            return value_.load(std::memory_order_acquire);
+        }
+
+        void Store(std::shared_ptr<const T> value) noexcept
+        {
+            value_.store(std::move(value), std::memory_order_release);
+        }
+
+    private:
+        std::atomic<std::shared_ptr<const T>> value_;
+    };
+
+} // namespace util
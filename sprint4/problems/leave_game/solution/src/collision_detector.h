@@ -3,6 +3,9 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <concepts>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 namespace collision_detector
@@ -29,16 +32,21 @@ namespace collision_detector
         int id;
         geom::Point2D position;
         double width;
+
+        bool operator==(const Item &) const = default;
     };
 
-    struct Gatherer
+    template <typename Id>
+    struct BasicGatherer
     {
-        std::string id;
+        Id id;
         geom::Point2D start_pos;
         geom::Point2D end_pos;
         double width;
     };
 
+    using Gatherer = BasicGatherer<std::string>;
+
     class ItemGathererProvider
     {
     protected:
@@ -51,14 +59,17 @@ namespace collision_detector
         virtual Gatherer GetGatherer(size_t idx) const = 0;
     };
 
-    struct GatheringEvent
+    template <typename GathererId>
+    struct BasicGatheringEvent
     {
         int item_id;
-        std::string gatherer_id;
+        GathererId gatherer_id;
         double sq_distance;
         double time;
     };
 
+    using GatheringEvent = BasicGatheringEvent<std::string>;
+
     class Provider : public ItemGathererProvider
     {
     public:
@@ -97,6 +108,215 @@ namespace collision_detector
         std::vector<Gatherer> gatherers_;
     };
 
+    // Если предметов меньше, они проверяются перебором, иначе сначала отсекаются по ограничивающим прямоугольникам
+    const size_t kBroadPhaseMinItems = 32;
+
+    /*
+     *  Источник предметов и собирателей без виртуальных вызовов.
+     *  Собиратель может иметь идентификатор любого типа, он попадёт в событие как есть.
+     */
+    template <typename Source>
+    concept GatherSource = requires(const Source &source, size_t idx) {
+        { source.ItemsCount() } -> std::convertible_to<size_t>;
+        { source.GetItem(idx) } -> std::convertible_to<Item>;
+        { source.GatherersCount() } -> std::convertible_to<size_t>;
+        { source.GetGatherer(idx).start_pos } -> std::convertible_to<geom::Point2D>;
+        { source.GetGatherer(idx).end_pos } -> std::convertible_to<geom::Point2D>;
+        { source.GetGatherer(idx).width } -> std::convertible_to<double>;
+        source.GetGatherer(idx).id;
+    };
+
+    // Приёмник предметов для IndexedGatherSource::ForEachItemNear (используется только в концепте)
+    struct ItemSink
+    {
+        void operator()(const Item &) const;
+    };
+
+    /*
+     *  Источник, который сам хранит предметы в пространственном индексе
+     *  и выдаёт только предметы, лежащие в прямоугольнике вокруг отрезка собирателя.
+     */
+    template <typename Source>
+    concept IndexedGatherSource = requires(const Source &source, size_t idx, double coord, ItemSink sink) {
+        { source.GatherersCount() } -> std::convertible_to<size_t>;
+        { source.GetGatherer(idx).start_pos } -> std::convertible_to<geom::Point2D>;
+        { source.GetGatherer(idx).end_pos } -> std::convertible_to<geom::Point2D>;
+        { source.GetGatherer(idx).width } -> std::convertible_to<double>;
+        source.GetGatherer(idx).id;
+        { source.MaxItemWidth() } -> std::convertible_to<double>;
+        source.ForEachItemNear(coord, coord, coord, coord, sink);
+    };
+
+    template <typename Source>
+        requires GatherSource<Source> || IndexedGatherSource<Source>
+    using GatheringEventFor = BasicGatheringEvent<std::decay_t<decltype(std::declval<const Source &>().GetGatherer(0).id)>>;
+
+    // Буферы, которые переиспользуются между вызовами, чтобы поиск не выделял память на каждом тике
+    struct GatherBuffers
+    {
+        std::vector<Item> items;
+        std::vector<size_t> by_x;
+        std::vector<size_t> candidates;
+    };
+
+    // Находит события сбора и записывает их в events, упорядочив по времени
+    template <typename Source>
+        requires GatherSource<Source> || IndexedGatherSource<Source>
+    void FindGatherEvents(const Source &source, std::vector<GatheringEventFor<Source>> &events, GatherBuffers &buffers)
+    {
+        events.clear();
+
+        if constexpr (IndexedGatherSource<Source>)
+        {
+            // Кандидаты берутся из индекса источника, глобальная сортировка предметов не нужна
+            const double max_item_width = source.MaxItemWidth();
+            auto &items = buffers.items;
+
+            for (size_t g = 0; g < source.GatherersCount(); ++g)
+            {
+                const auto gatherer = source.GetGatherer(g);
+                const geom::Point2D start_pos = gatherer.start_pos;
+                const geom::Point2D end_pos = gatherer.end_pos;
+
+                if (start_pos.x == end_pos.x && start_pos.y == end_pos.y)
+                {
+                    continue;
+                }
+
+                const double reach = gatherer.width + max_item_width;
+                items.clear();
+                source.ForEachItemNear(std::min(start_pos.x, end_pos.x) - reach,
+                                       std::min(start_pos.y, end_pos.y) - reach,
+                                       std::max(start_pos.x, end_pos.x) + reach,
+                                       std::max(start_pos.y, end_pos.y) + reach,
+                                       [&items](const Item &item)
+                                       { items.push_back(item); });
+
+                // Порядок ячеек индекса не определён, поэтому проверяем в порядке идентификаторов
+                std::sort(items.begin(), items.end(), [](const Item &l, const Item &r)
+                          { return l.id != r.id ? l.id < r.id : l.position < r.position; });
+
+                for (const Item &item : items)
+                {
+                    auto collect_result = TryCollectPoint(start_pos, end_pos, item.position);
+
+                    if (collect_result.IsCollected(gatherer.width + item.width))
+                    {
+                        events.push_back({.item_id = item.id,
+                                          .gatherer_id = gatherer.id,
+                                          .sq_distance = collect_result.sq_distance,
+                                          .time = collect_result.proj_ratio});
+                    }
+                }
+            }
+
+            std::sort(events.begin(), events.end(),
+                      [](const auto &e_l, const auto &e_r)
+                      {
+                          return e_l.time < e_r.time;
+                      });
+            return;
+        }
+        else
+        {
+            const size_t items_count = source.ItemsCount();
+
+            auto &items = buffers.items;
+            items.clear();
+            double max_item_width = 0.0;
+
+            for (size_t i = 0; i < items_count; ++i)
+            {
+                const Item &item = items.emplace_back(source.GetItem(i));
+                max_item_width = std::max(max_item_width, item.width);
+            }
+
+            // Broad phase (sweep and prune): предметы упорядочиваются по x,
+            // собирателю достаются только предметы из полосы вокруг его отрезка
+            const bool use_sweep = items_count >= kBroadPhaseMinItems;
+            auto &by_x = buffers.by_x;
+
+            if (use_sweep)
+            {
+                by_x.resize(items_count);
+                for (size_t i = 0; i < items_count; ++i)
+                {
+                    by_x[i] = i;
+                }
+
+                std::sort(by_x.begin(), by_x.end(), [&items](size_t l, size_t r)
+                          { return items[l].position.x < items[r].position.x; });
+            }
+
+            auto &candidates = buffers.candidates;
+
+            for (size_t g = 0; g < source.GatherersCount(); ++g)
+            {
+                const auto gatherer = source.GetGatherer(g);
+                const geom::Point2D start_pos = gatherer.start_pos;
+                const geom::Point2D end_pos = gatherer.end_pos;
+
+                if (start_pos.x == end_pos.x && start_pos.y == end_pos.y)
+                {
+                    continue;
+                }
+
+                candidates.clear();
+
+                if (use_sweep)
+                {
+                    const double reach = gatherer.width + max_item_width;
+                    const double min_x = std::min(start_pos.x, end_pos.x) - reach;
+                    const double max_x = std::max(start_pos.x, end_pos.x) + reach;
+                    const double min_y = std::min(start_pos.y, end_pos.y) - reach;
+                    const double max_y = std::max(start_pos.y, end_pos.y) + reach;
+
+                    auto it = std::lower_bound(by_x.begin(), by_x.end(), min_x, [&items](size_t i, double x)
+                                               { return items[i].position.x < x; });
+
+                    for (; it != by_x.end() && items[*it].position.x <= max_x; ++it)
+                    {
+                        const double y = items[*it].position.y;
+                        if (y >= min_y && y <= max_y)
+                            candidates.push_back(*it);
+                    }
+
+                    // Порядок проверки как при полном переборе, чтобы события совпадали
+                    std::sort(candidates.begin(), candidates.end());
+                }
+                else
+                {
+                    for (size_t i = 0; i < items_count; ++i)
+                    {
+                        candidates.push_back(i);
+                    }
+                }
+
+                // Narrow phase
+                for (size_t i : candidates)
+                {
+                    const Item &item = items[i];
+                    auto collect_result = TryCollectPoint(start_pos, end_pos, item.position);
+
+                    if (collect_result.IsCollected(gatherer.width + item.width))
+                    {
+                        events.push_back({.item_id = item.id,
+                                          .gatherer_id = gatherer.id,
+                                          .sq_distance = collect_result.sq_distance,
+                                          .time = collect_result.proj_ratio});
+                    }
+                }
+            }
+
+            std::sort(events.begin(), events.end(),
+                      [](const auto &e_l, const auto &e_r)
+                      {
+                          return e_l.time < e_r.time;
+                      });
+        }
+    }
+
+    // Вариант с виртуальным провайдером, создаёт буферы на каждый вызов
     std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider &provider);
 
 } // namespace collision_detector
\ No newline at end of file
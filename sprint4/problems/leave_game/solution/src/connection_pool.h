@@ -0,0 +1,371 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace database
+{
+
+    struct ConnectionPoolStats
+    {
+        size_t capacity = 0;
+        size_t in_use = 0;
+        size_t waiting = 0;
+        uint64_t acquired = 0;
+        // Ожидания, не дождавшиеся соединения за отведённое время
+        uint64_t timeouts = 0;
+        uint64_t reconnects = 0;
+        uint64_t reconnect_failures = 0;
+        uint64_t total_wait_us = 0;
+        uint64_t max_wait_us = 0;
+    };
+
+    /*
+     *  Пул соединений с очередью ожидающих. Асинхронное получение не блокирует поток:
+     *  обработчик встаёт в очередь и вызывается на своём executor, когда соединение вернут,
+     *  или с ошибкой timed_out по истечении срока. Перед выдачей соединение проверяется
+     *  health_check (после долгого простоя - запросом к базе) и при необходимости пересоздаётся.
+     *  Запросы к базе выполняются на собственных потоках пула, а не на потоках io_context.
+     *  Тип соединения - параметр шаблона, чтобы очередь и пересоздание проверялись без базы данных.
+     */
+    template <typename Connection>
+    class BasicConnectionPool : public std::enable_shared_from_this<BasicConnectionPool<Connection>>
+    {
+        using PoolType = BasicConnectionPool;
+        using ConnectionPtr = std::shared_ptr<Connection>;
+        using Clock = std::chrono::steady_clock;
+
+    public:
+        class ConnectionWrapper
+        {
+        public:
+            ConnectionWrapper() = default;
+
+            ConnectionWrapper(std::shared_ptr<Connection> &&conn,
+                              PoolType &pool) noexcept
+                : conn_{std::move(conn)}, pool_{&pool} {}
+
+            ConnectionWrapper(const ConnectionWrapper &) = delete;
+            ConnectionWrapper &operator=(const ConnectionWrapper &) = delete;
+
+            ConnectionWrapper(ConnectionWrapper &&other) noexcept
+                : conn_{std::move(other.conn_)}, pool_{other.pool_} {}
+
+            ConnectionWrapper &operator=(ConnectionWrapper &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    Release();
+                    conn_ = std::move(other.conn_);
+                    pool_ = other.pool_;
+                }
+                return *this;
+            }
+
+            Connection &operator*() const & noexcept { return *conn_; }
+            Connection &operator*() const && = delete;
+
+            Connection *operator->() const & noexcept { return conn_.get(); }
+
+            explicit operator bool() const noexcept { return conn_ != nullptr; }
+
+            ~ConnectionWrapper()
+            {
+                Release();
+            }
+
+        private:
+            void Release() noexcept
+            {
+                if (conn_)
+                {
+                    pool_->ReturnConnection(std::move(conn_));
+                }
+            }
+
+            std::shared_ptr<Connection> conn_;
+            PoolType *pool_ = nullptr;
+        };
+
+        using AcquireHandler = std::function<void(boost::system::error_code, ConnectionWrapper)>;
+        // Проверка соединения перед выдачей; idle - соединение простаивало дольше kHealthCheckIdleTime
+        using HealthCheck = std::function<bool(Connection &conn, bool idle)>;
+
+        static constexpr std::chrono::milliseconds kDefaultAcquireTimeout{5000};
+        static constexpr std::chrono::milliseconds kHealthCheckIdleTime{30000};
+
+        BasicConnectionPool() = delete;
+        BasicConnectionPool(const BasicConnectionPool &) = delete;
+        BasicConnectionPool &operator=(const BasicConnectionPool &) = delete;
+
+        // ConnectionFactory is a functional object returning
+        // std::shared_ptr<Connection>
+        template <typename ConnectionFactory>
+        BasicConnectionPool(size_t capacity, ConnectionFactory &&connection_factory, HealthCheck health_check = {})
+            : factory_{std::forward<ConnectionFactory>(connection_factory)}, health_check_{std::move(health_check)},
+              capacity_{capacity}, query_threads_{std::max<size_t>(1, capacity)}
+        {
+            idle_.reserve(capacity);
+            for (size_t i = 0; i < capacity; ++i)
+            {
+                idle_.push_back({factory_(), Clock::now()});
+            }
+        }
+
+        // Блокирующее получение; только для потоков вне io_context. По истечении timeout бросает исключение
+        ConnectionWrapper GetConnection(std::chrono::milliseconds timeout = kDefaultAcquireTimeout)
+        {
+            auto promise = std::make_shared<std::promise<IdleConnection>>();
+            auto future = promise->get_future();
+
+            auto waiter = std::make_shared<Waiter>();
+            waiter->since = Clock::now();
+            waiter->complete = [promise](boost::system::error_code, IdleConnection idle)
+            {
+                promise->set_value(std::move(idle));
+            };
+            Acquire(waiter);
+
+            // После истечения срока соединение могло уже уйти к ожидающему, тогда get() дождётся его
+            if (future.wait_for(timeout) != std::future_status::ready)
+            {
+                Expire(waiter);
+            }
+
+            IdleConnection idle = future.get();
+            if (!idle.conn)
+            {
+                throw std::runtime_error("Timed out waiting for a database connection");
+            }
+
+            if (!EnsureHealthy(idle))
+            {
+                ReturnConnection(std::move(idle.conn), Clock::time_point{});
+                throw std::runtime_error("Database connection is lost");
+            }
+            return {std::move(idle.conn), *this};
+        }
+
+        // Обработчик вызывается через executor с соединением или с ошибкой timed_out / not_connected
+        void AsyncGetConnection(boost::asio::any_io_executor executor, AcquireHandler handler,
+                                std::chrono::milliseconds timeout = kDefaultAcquireTimeout)
+        {
+            namespace net = boost::asio;
+            namespace sys = boost::system;
+
+            auto shared_handler = std::make_shared<AcquireHandler>(std::move(handler));
+            std::weak_ptr<PoolType> weak_pool = this->weak_from_this();
+
+            auto waiter = std::make_shared<Waiter>();
+            waiter->since = Clock::now();
+            waiter->complete = [weak_pool, executor, shared_handler](sys::error_code ec, IdleConnection idle)
+            {
+                auto pool = weak_pool.lock();
+                if (!pool)
+                {
+                    return;
+                }
+
+                if (ec)
+                {
+                    net::post(executor, [shared_handler, ec]
+                              { (*shared_handler)(ec, {}); });
+                    return;
+                }
+
+                // Проверка соединения может ходить в базу, поэтому выполняется на потоках запросов
+                net::post(pool->GetQueryExecutor(), [pool, executor, shared_handler, idle = std::move(idle)]() mutable
+                          {
+                              if (!pool->EnsureHealthy(idle))
+                              {
+                                  pool->ReturnConnection(std::move(idle.conn), Clock::time_point{});
+                                  net::post(executor, [shared_handler]
+                                            { (*shared_handler)(make_error_code(sys::errc::not_connected), {}); });
+                                  return;
+                              }
+
+                              ConnectionWrapper conn{std::move(idle.conn), *pool};
+                              net::post(executor, [shared_handler, conn = std::move(conn)]() mutable
+                                        { (*shared_handler)({}, std::move(conn)); }); });
+            };
+
+            if (timeout.count() > 0)
+            {
+                waiter->timer = std::make_unique<net::steady_timer>(executor, timeout);
+                waiter->timer->async_wait([weak_pool, waiter](sys::error_code ec)
+                                          {
+                                              if (ec)
+                                              {
+                                                  return;
+                                              }
+                                              if (auto pool = weak_pool.lock())
+                                              {
+                                                  pool->Expire(waiter);
+                                              } });
+            }
+
+            Acquire(waiter);
+        }
+
+        // Потоки для запросов к базе, по одному на соединение
+        boost::asio::any_io_executor GetQueryExecutor() noexcept { return query_threads_.get_executor(); }
+
+        ConnectionPoolStats GetStats() const
+        {
+            ConnectionPoolStats stats;
+            stats.capacity = capacity_;
+            stats.acquired = acquired_.load(std::memory_order_relaxed);
+            stats.timeouts = timeouts_.load(std::memory_order_relaxed);
+            stats.reconnects = reconnects_.load(std::memory_order_relaxed);
+            stats.reconnect_failures = reconnect_failures_.load(std::memory_order_relaxed);
+            stats.total_wait_us = total_wait_us_.load(std::memory_order_relaxed);
+            stats.max_wait_us = max_wait_us_.load(std::memory_order_relaxed);
+
+            std::lock_guard lock{mutex_};
+            stats.in_use = capacity_ - idle_.size();
+            stats.waiting = waiting_;
+            return stats;
+        }
+
+    private:
+        struct IdleConnection
+        {
+            ConnectionPtr conn;
+            Clock::time_point since;
+        };
+
+        struct Waiter
+        {
+            std::function<void(boost::system::error_code, IdleConnection)> complete;
+            Clock::time_point since;
+            bool done = false;
+            std::unique_ptr<boost::asio::steady_timer> timer;
+        };
+
+        void Acquire(const std::shared_ptr<Waiter> &waiter)
+        {
+            IdleConnection idle;
+            {
+                std::lock_guard lock{mutex_};
+                if (idle_.empty())
+                {
+                    // Свободных соединений нет: ожидающий получит первое возвращённое
+                    waiters_.push_back(waiter);
+                    ++waiting_;
+                    return;
+                }
+
+                idle = std::move(idle_.back());
+                idle_.pop_back();
+                waiter->done = true;
+            }
+            HandOver(waiter, std::move(idle));
+        }
+
+        void Expire(const std::shared_ptr<Waiter> &waiter)
+        {
+            {
+                std::lock_guard lock{mutex_};
+                if (waiter->done)
+                {
+                    return;
+                }
+                waiter->done = true;
+                waiters_.erase(std::find(waiters_.begin(), waiters_.end(), waiter));
+                --waiting_;
+            }
+            timeouts_.fetch_add(1, std::memory_order_relaxed);
+            waiter->complete(make_error_code(boost::system::errc::timed_out), {});
+        }
+
+        // Время простоя since по умолчанию - сейчас; нулевое заставит проверить соединение при выдаче
+        void ReturnConnection(ConnectionPtr &&conn, Clock::time_point since = Clock::now())
+        {
+            std::shared_ptr<Waiter> waiter;
+            {
+                std::lock_guard lock{mutex_};
+                if (waiters_.empty())
+                {
+                    idle_.push_back({std::move(conn), since});
+                    return;
+                }
+
+                // Соединение сразу переходит к самому давнему ожидающему
+                waiter = std::move(waiters_.front());
+                waiters_.pop_front();
+                --waiting_;
+                waiter->done = true;
+            }
+            HandOver(waiter, {std::move(conn), since});
+        }
+
+        void HandOver(const std::shared_ptr<Waiter> &waiter, IdleConnection &&idle)
+        {
+            if (waiter->timer)
+            {
+                waiter->timer->cancel();
+            }
+
+            const auto wait_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - waiter->since).count());
+            acquired_.fetch_add(1, std::memory_order_relaxed);
+            total_wait_us_.fetch_add(wait_us, std::memory_order_relaxed);
+            uint64_t max_wait = max_wait_us_.load(std::memory_order_relaxed);
+            while (wait_us > max_wait && !max_wait_us_.compare_exchange_weak(max_wait, wait_us, std::memory_order_relaxed))
+            {
+            }
+
+            waiter->complete({}, std::move(idle));
+        }
+
+        // Проверяет соединение перед выдачей и пересоздаёт его; false, если пересоздать не удалось
+        bool EnsureHealthy(IdleConnection &idle)
+        {
+            if (idle.conn && (!health_check_ || health_check_(*idle.conn, Clock::now() - idle.since >= kHealthCheckIdleTime)))
+            {
+                return true;
+            }
+
+            try
+            {
+                idle.conn = factory_();
+                reconnects_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            catch (const std::exception &)
+            {
+                reconnect_failures_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        std::function<ConnectionPtr()> factory_;
+        HealthCheck health_check_;
+        const size_t capacity_;
+
+        mutable std::mutex mutex_;
+        std::vector<IdleConnection> idle_;
+        std::deque<std::shared_ptr<Waiter>> waiters_;
+        size_t waiting_ = 0;
+
+        std::atomic<uint64_t> acquired_{0};
+        std::atomic<uint64_t> timeouts_{0};
+        std::atomic<uint64_t> reconnects_{0};
+        std::atomic<uint64_t> reconnect_failures_{0};
+        std::atomic<uint64_t> total_wait_us_{0};
+        std::atomic<uint64_t> max_wait_us_{0};
+
+        // Уничтожается первым: незавершённые запросы возвращают соединения в ещё живой пул
+        boost::asio::thread_pool query_threads_;
+    };
+
+} // namespace database
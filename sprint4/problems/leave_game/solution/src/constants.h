@@ -46,4 +46,9 @@ namespace constant
     const std::string kLostObjects = "lostObjects";
 
     const std::string kDogRetirementTime = "dogRetirementTime";
+    const std::string kMaxPlayersPerSession = "maxPlayersPerSession";
+    const std::string kRandomSeed = "randomSeed";
+    const std::string kMaxLoot = "maxLoot";
+    const std::string kDefaultMaxLoot = "defaultMaxLoot";
+    const std::string kMaxTickStep = "maxTickStep";
 }
\ No newline at end of file
@@ -1,46 +1,85 @@
 #include "database.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace database
 {
 
+    namespace net = boost::asio;
+    namespace sys = boost::system;
+
     using namespace std::literals;
     using pqxx::operator"" _zv;
 
-    ConnectionPool::ConnectionWrapper ConnectionPool::GetConnection()
+    bool CheckConnection(pqxx::connection &connection, bool idle)
     {
-        std::unique_lock lock{mutex_};
-        // Блокируем текущий поток и ждём, пока cond_var_ не получит уведомление и
-        // не освободится хотя бы одно соединение
-        cond_var_.wait(lock, [this]
-                       { return used_connections_ < pool_.size(); });
-        // После выхода из цикла ожидания мьютекс остаётся захваченным
+        if (!connection.is_open())
+        {
+            return false;
+        }
+        if (!idle)
+        {
+            return true;
+        }
 
-        return {std::move(pool_[used_connections_++]), *this};
+        try
+        {
+            pqxx::nontransaction ping{connection};
+            ping.exec("SELECT 1;"_zv);
+            return true;
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
     }
 
-    void ConnectionPool::ReturnConnection(ConnectionPtr &&conn)
+    namespace
     {
-        // Возвращаем соединение обратно в пул
-        {
-            std::lock_guard lock{mutex_};
-            pool_[--used_connections_] = std::move(conn);
-        }
-        // Уведомляем один из ожидающих потоков об изменении состояния пула
-        cond_var_.notify_one();
+        const pqxx::zview kInsertRecord = "insert_record"_zv;
+        const pqxx::zview kSelectRecordsPage = "select_records_page"_zv;
+        const pqxx::zview kSelectRecordsAfter = "select_records_after"_zv;
+    } // namespace
+
+    void PlayerRecordRepository::PrepareStatements(pqxx::connection &connection)
+    {
+        connection.prepare(kInsertRecord, R"(
+            INSERT INTO hall_of_fame (name, score, play_time) VALUES ($1, $2, $3);
+            )"_zv);
+
+        // Порядок совпадает с индексом hall_of_fame_leaderboard, поэтому страница читается из индекса
+        connection.prepare(kSelectRecordsPage, R"(
+            SELECT name, score, play_time FROM hall_of_fame
+            ORDER BY -score, play_time, name COLLATE "C"
+            LIMIT $1 OFFSET $2;
+            )"_zv);
+
+        connection.prepare(kSelectRecordsAfter, R"(
+            SELECT name, score, play_time FROM hall_of_fame
+            WHERE (-score, play_time, name COLLATE "C") > (-$1::integer, $2::integer, $3::varchar COLLATE "C")
+            ORDER BY -score, play_time, name COLLATE "C"
+            LIMIT $4;
+            )"_zv);
     }
 
     void PlayerRecordRepository::SavePlayerRecordsTable(const std::vector<PlayerRecord> &player_records)
     {
+        if (player_records.empty())
+        {
+            return;
+        }
+
         auto conn = connection_pool_->GetConnection();
         pqxx::work work_{*conn};
+        // Вся пачка уходит одним COPY вместо отдельного INSERT на каждую запись
+        auto stream = pqxx::stream_to::table(work_, {"hall_of_fame"}, {"name", "score", "play_time"});
         for (const auto &player_record : player_records)
         {
-            work_.exec_params(R"(
-            INSERT INTO hall_of_fame (name, score, play_time) VALUES ($1, $2, $3);
-            )"_zv,
-                              player_record.GetName(), player_record.GetScore(),
-                              player_record.GetPlayTime());
+            stream.write_values(player_record.GetName(), player_record.GetScore(),
+                                player_record.GetPlayTime());
         }
+        stream.complete();
         work_.commit();
     }
 
@@ -49,11 +88,8 @@ namespace database
         auto conn = connection_pool_->GetConnection();
         pqxx::work work_{*conn};
 
-        work_.exec_params(R"(
-            INSERT INTO hall_of_fame (name, score, play_time) VALUES ($1, $2, $3);
-            )"_zv,
-                          player_record.GetName(), player_record.GetScore(),
-                          player_record.GetPlayTime());
+        work_.exec_prepared(kInsertRecord, player_record.GetName(), player_record.GetScore(),
+                            player_record.GetPlayTime());
 
         work_.commit();
     }
@@ -61,18 +97,319 @@ namespace database
     std::vector<PlayerRecord> PlayerRecordRepository::GetRecordsTable(size_t offset, size_t limit)
     {
         auto conn = connection_pool_->GetConnection();
+        return ReadRecords(*conn, offset, limit, std::nullopt);
+    }
+
+    std::vector<PlayerRecord> PlayerRecordRepository::GetRecordsTableAfter(const PlayerRecord &cursor, size_t limit)
+    {
+        auto conn = connection_pool_->GetConnection();
+        return ReadRecords(*conn, 0, limit, cursor);
+    }
+
+    void PlayerRecordRepository::AsyncGetRecordsTable(size_t offset, size_t limit, std::optional<PlayerRecord> cursor,
+                                                      net::any_io_executor executor, RecordsHandler handler)
+    {
+        // Соединение выдаётся сразу на поток запросов: ожидание и запрос не занимают потоки io_context
+        connection_pool_->AsyncGetConnection(
+            connection_pool_->GetQueryExecutor(),
+            [offset, limit, cursor = std::move(cursor), executor, handler = std::move(handler)](sys::error_code ec, ConnectionPool::ConnectionWrapper conn) mutable
+            {
+                std::vector<PlayerRecord> records;
+                if (!ec)
+                {
+                    try
+                    {
+                        records = ReadRecords(*conn, offset, limit, cursor);
+                    }
+                    catch (const std::exception &)
+                    {
+                        ec = make_error_code(sys::errc::io_error);
+                    }
+                }
+
+                net::post(executor, [handler = std::move(handler), ec, records = std::move(records)]() mutable
+                          { handler(ec, std::move(records)); });
+            });
+    }
+
+    std::vector<PlayerRecord> PlayerRecordRepository::ReadRecords(pqxx::connection &connection, size_t offset, size_t limit,
+                                                                  const std::optional<PlayerRecord> &cursor)
+    {
         std::vector<PlayerRecord> records_table;
-        pqxx::read_transaction read_transaction_{*conn};
-        auto query_text = "SELECT name, score, play_time FROM hall_of_fame ORDER "
-                          "BY score DESC, play_time ASC, name ASC LIMIT " +
-                          std::to_string(limit) + " OFFSET " +
-                          std::to_string(offset) + ";";
-        for (auto [name, score, play_time] :
-             read_transaction_.query<std::string, size_t, int64_t>(query_text))
+        records_table.reserve(limit);
+        pqxx::read_transaction read_transaction_{connection};
+        auto result = cursor ? read_transaction_.exec_prepared(kSelectRecordsAfter, cursor->GetScore(), cursor->GetPlayTime(), cursor->GetName(), limit)
+                             : read_transaction_.exec_prepared(kSelectRecordsPage, limit, offset);
+        for (auto [name, score, play_time] : result.iter<std::string, size_t, int64_t>())
         {
             records_table.emplace_back(name, score, play_time);
         }
         return records_table;
     }
 
+    RecordWriter::RecordWriter(Sink sink, size_t capacity, size_t max_batch, std::chrono::milliseconds flush_interval)
+        : sink_{std::move(sink)}, queue_{capacity}, max_batch_{std::max<size_t>(1, max_batch)}, flush_interval_{flush_interval}
+    {
+        batch_.reserve(max_batch_);
+        worker_ = std::thread{[this]
+                              { Run(); }};
+    }
+
+    RecordWriter::~RecordWriter()
+    {
+        Stop();
+    }
+
+    bool RecordWriter::Push(PlayerRecord record)
+    {
+        if (stopping_.load(std::memory_order_acquire) || !queue_.TryPush(std::move(record)))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        enqueued_.fetch_add(1, std::memory_order_release);
+
+        const size_t depth = queue_.Size();
+        size_t max_depth = max_depth_.load(std::memory_order_relaxed);
+        while (depth > max_depth && !max_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed))
+        {
+        }
+
+        // Будим поток записи только при первом рекорде после его пробуждения
+        if (!signaled_.exchange(true))
+        {
+            wake_.release();
+        }
+        return true;
+    }
+
+    void RecordWriter::Flush()
+    {
+        const uint64_t target = enqueued_.load(std::memory_order_acquire);
+        wake_.release();
+
+        std::unique_lock lock{flush_mutex_};
+        flushed_.wait(lock, [this, target]
+                      { return processed_.load(std::memory_order_acquire) >= target || stopped_.load(std::memory_order_acquire); });
+    }
+
+    void RecordWriter::Stop()
+    {
+        std::lock_guard lock{stop_mutex_};
+        if (!worker_.joinable())
+        {
+            return;
+        }
+
+        stopping_.store(true, std::memory_order_release);
+        wake_.release();
+        worker_.join();
+
+        {
+            std::lock_guard flush_lock{flush_mutex_};
+            stopped_.store(true, std::memory_order_release);
+        }
+        flushed_.notify_all();
+    }
+
+    RecordWriterStats RecordWriter::GetStats() const noexcept
+    {
+        RecordWriterStats stats;
+        stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+        stats.written = written_.load(std::memory_order_relaxed);
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        stats.failed = failed_.load(std::memory_order_relaxed);
+        stats.batches = batches_.load(std::memory_order_relaxed);
+        stats.depth = queue_.Size();
+        stats.max_depth = max_depth_.load(std::memory_order_relaxed);
+        stats.capacity = queue_.Capacity();
+        return stats;
+    }
+
+    void RecordWriter::Run()
+    {
+        for (;;)
+        {
+            static_cast<void>(wake_.try_acquire_for(flush_interval_));
+            signaled_.store(false);
+
+            while (WriteBatch() > 0)
+            {
+            }
+
+            if (stopping_.load(std::memory_order_acquire))
+            {
+                // Писатели могли успеть добавить рекорды до того, как увидели остановку
+                while (WriteBatch() > 0)
+                {
+                }
+                return;
+            }
+        }
+    }
+
+    size_t RecordWriter::WriteBatch()
+    {
+        batch_.clear();
+        while (batch_.size() < max_batch_)
+        {
+            auto record = queue_.TryPop();
+            if (!record)
+            {
+                break;
+            }
+            batch_.push_back(std::move(*record));
+        }
+
+        if (batch_.empty())
+        {
+            return 0;
+        }
+
+        try
+        {
+            sink_(batch_);
+            written_.fetch_add(batch_.size(), std::memory_order_relaxed);
+        }
+        catch (...)
+        {
+            failed_.fetch_add(batch_.size(), std::memory_order_relaxed);
+        }
+        batches_.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            std::lock_guard lock{flush_mutex_};
+            processed_.fetch_add(batch_.size(), std::memory_order_release);
+        }
+        flushed_.notify_all();
+
+        return batch_.size();
+    }
+
+    bool Leaderboard::Precedes(const PlayerRecord &lhs, const PlayerRecord &rhs) noexcept
+    {
+        if (lhs.GetScore() != rhs.GetScore())
+        {
+            return lhs.GetScore() > rhs.GetScore();
+        }
+        if (lhs.GetPlayTime() != rhs.GetPlayTime())
+        {
+            return lhs.GetPlayTime() < rhs.GetPlayTime();
+        }
+        return lhs.GetName() < rhs.GetName();
+    }
+
+    void Leaderboard::Seed(std::vector<PlayerRecord> records, bool complete)
+    {
+        std::stable_sort(records.begin(), records.end(), Precedes);
+
+        std::lock_guard lock{mutex_};
+        records_ = std::move(records);
+        complete_ = complete;
+        Trim();
+        ++version_;
+        pages_.clear();
+    }
+
+    void Leaderboard::Add(const std::vector<PlayerRecord> &records)
+    {
+        if (records.empty())
+        {
+            return;
+        }
+
+        std::lock_guard lock{mutex_};
+        bool changed = false;
+        for (const auto &record : records)
+        {
+            // Рекорд ниже последнего хранимого не попадает в неполную таблицу
+            if (!complete_ && !records_.empty() && !Precedes(record, records_.back()))
+            {
+                continue;
+            }
+            records_.insert(std::upper_bound(records_.begin(), records_.end(), record, Precedes), record);
+            changed = true;
+        }
+
+        if (!changed)
+        {
+            return;
+        }
+        Trim();
+        ++version_;
+        pages_.clear();
+    }
+
+    Leaderboard::Page Leaderboard::GetPage(size_t offset, size_t limit, const PageSerializer &serializer)
+    {
+        std::unique_lock lock{mutex_};
+        return GetPageLocked(lock, offset, limit, serializer);
+    }
+
+    Leaderboard::Page Leaderboard::GetPageAfter(const PlayerRecord &cursor, size_t limit, const PageSerializer &serializer)
+    {
+        std::unique_lock lock{mutex_};
+        const auto offset = static_cast<size_t>(std::upper_bound(records_.begin(), records_.end(), cursor, Precedes) - records_.begin());
+        return GetPageLocked(lock, offset, limit, serializer);
+    }
+
+    Leaderboard::Page Leaderboard::GetPageLocked(std::unique_lock<std::mutex> &lock, size_t offset, size_t limit, const PageSerializer &serializer)
+    {
+        if (!complete_ && (offset > records_.size() || limit > records_.size() - offset))
+        {
+            fallbacks_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        if (auto it = pages_.find({offset, limit}); it != pages_.end())
+        {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+
+        const size_t first = std::min(offset, records_.size());
+        const size_t last = first + std::min(limit, records_.size() - first);
+        std::vector<PlayerRecord> slice(records_.begin() + first, records_.begin() + last);
+        const uint64_t version = version_;
+
+        // Сериализация идёт без блокировки; страница, устаревшая к её концу, отдаётся, но не кешируется
+        lock.unlock();
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        auto page = std::make_shared<const std::string>(serializer(slice));
+
+        lock.lock();
+        if (version == version_)
+        {
+            if (pages_.size() >= kMaxCachedPages)
+            {
+                pages_.clear();
+            }
+            pages_.emplace(PageKey{offset, limit}, page);
+        }
+        return page;
+    }
+
+    LeaderboardStats Leaderboard::GetStats() const
+    {
+        LeaderboardStats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.fallbacks = fallbacks_.load(std::memory_order_relaxed);
+        stats.capacity = capacity_;
+
+        std::lock_guard lock{mutex_};
+        stats.version = version_;
+        stats.size = records_.size();
+        return stats;
+    }
+
+    void Leaderboard::Trim()
+    {
+        if (records_.size() > capacity_)
+        {
+            records_.erase(records_.begin() + static_cast<std::ptrdiff_t>(capacity_), records_.end());
+            complete_ = false;
+        }
+    }
+
 } // namespace database
\ No newline at end of file
@@ -3,9 +3,23 @@
 #include "pqxx/connection"
 #include "pqxx/zview.hxx"
 #include "pqxx/pqxx"
+#include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <semaphore>
+#include <span>
+#include <thread>
+
+#include "mpsc_queue.h"
+#include "connection_pool.h"
 
 namespace database
 {
@@ -24,69 +38,10 @@ namespace database
         std::string db_url{};
     };
 
-    class ConnectionPool
-    {
-        using PoolType = ConnectionPool;
-        using ConnectionPtr = std::shared_ptr<pqxx::connection>;
-
-    public:
-        class ConnectionWrapper
-        {
-        public:
-            ConnectionWrapper(std::shared_ptr<pqxx::connection> &&conn,
-                              PoolType &pool) noexcept
-                : conn_{std::move(conn)}, pool_{&pool} {}
-
-            ConnectionWrapper(const ConnectionWrapper &) = delete;
-            ConnectionWrapper &operator=(const ConnectionWrapper &) = delete;
-
-            ConnectionWrapper(ConnectionWrapper &&) = default;
-            ConnectionWrapper &operator=(ConnectionWrapper &&) = default;
-
-            pqxx::connection &operator*() const & noexcept { return *conn_; }
-            pqxx::connection &operator*() const && = delete;
-
-            pqxx::connection *operator->() const & noexcept { return conn_.get(); }
-
-            ~ConnectionWrapper()
-            {
-                if (conn_)
-                {
-                    pool_->ReturnConnection(std::move(conn_));
-                }
-            }
-
-        private:
-            std::shared_ptr<pqxx::connection> conn_;
-            PoolType *pool_;
-        };
-
-        ConnectionPool() = delete;
-        ConnectionPool(const ConnectionPool &) = delete;
-        ConnectionPool &operator=(const ConnectionPool &) = delete;
-
-        // ConnectionFactory is a functional object returning
-        // std::shared_ptr<pqxx::connection>
-        template <typename ConnectionFactory>
-        ConnectionPool(size_t capacity, ConnectionFactory &&connection_factory)
-        {
-            pool_.reserve(capacity);
-            for (size_t i = 0; i < capacity; ++i)
-            {
-                pool_.emplace_back(connection_factory());
-            }
-        }
-
-        ConnectionWrapper GetConnection();
+    using ConnectionPool = BasicConnectionPool<pqxx::connection>;
 
-    private:
-        void ReturnConnection(ConnectionPtr &&conn);
-
-        std::mutex mutex_;
-        std::condition_variable cond_var_;
-        std::vector<ConnectionPtr> pool_;
-        size_t used_connections_ = 0;
-    };
+    // Проверка соединения для пула: открыто ли оно, а после долгого простоя - отвечает ли на SELECT 1
+    bool CheckConnection(pqxx::connection &connection, bool idle);
 
     class PlayerRecord
     {
@@ -112,45 +67,233 @@ namespace database
         explicit PlayerRecordRepository(std::shared_ptr<ConnectionPool> &connection_pool)
             : connection_pool_(connection_pool){};
 
+        // Регистрирует подготовленные выражения на новом соединении пула
+        static void PrepareStatements(pqxx::connection &connection);
+
         void SavePlayerRecordsTable(const std::vector<PlayerRecord> &player_records);
 
         void SavePlayerRecord(PlayerRecord &player_record);
 
         std::vector<PlayerRecord> GetRecordsTable(size_t offset, size_t limit);
 
+        // Страница рекордов, следующих за cursor; стоимость не зависит от глубины страницы
+        std::vector<PlayerRecord> GetRecordsTableAfter(const PlayerRecord &cursor, size_t limit);
+
+        using RecordsHandler = std::function<void(boost::system::error_code, std::vector<PlayerRecord>)>;
+
+        // Неблокирующее чтение страницы: при заданном cursor offset не используется, handler вызывается через executor
+        void AsyncGetRecordsTable(size_t offset, size_t limit, std::optional<PlayerRecord> cursor,
+                                  boost::asio::any_io_executor executor, RecordsHandler handler);
+
     private:
+        static std::vector<PlayerRecord> ReadRecords(pqxx::connection &connection, size_t offset, size_t limit,
+                                                     const std::optional<PlayerRecord> &cursor);
+
         std::shared_ptr<ConnectionPool> &connection_pool_;
     };
 
+    struct RecordWriterStats
+    {
+        uint64_t enqueued = 0;
+        uint64_t written = 0;
+        // Не поместились в заполненную очередь или пришли после остановки
+        uint64_t dropped = 0;
+        uint64_t failed = 0;
+        uint64_t batches = 0;
+        size_t depth = 0;
+        size_t max_depth = 0;
+        size_t capacity = 0;
+    };
+
+    /*
+     *  Отложенная запись рекордов. Тик кладёт рекорд в ограниченную очередь без блокировок,
+     *  отдельный поток забирает накопившиеся рекорды пачками и записывает каждую пачку одной транзакцией.
+     *  Задержки базы данных не доходят до тика: при заполненной очереди рекорд отбрасывается и учитывается в dropped.
+     */
+    class RecordWriter
+    {
+    public:
+        using Sink = std::function<void(const std::vector<PlayerRecord> &)>;
+
+        static constexpr size_t kDefaultCapacity = 4096;
+        static constexpr size_t kDefaultMaxBatch = 256;
+        static constexpr std::chrono::milliseconds kDefaultFlushInterval{100};
+
+        explicit RecordWriter(Sink sink, size_t capacity = kDefaultCapacity, size_t max_batch = kDefaultMaxBatch,
+                              std::chrono::milliseconds flush_interval = kDefaultFlushInterval);
+
+        RecordWriter(const RecordWriter &) = delete;
+        RecordWriter &operator=(const RecordWriter &) = delete;
+
+        ~RecordWriter();
+
+        // Возвращает false, если рекорд отброшен
+        bool Push(PlayerRecord record);
+
+        // Дожидается записи всех рекордов, добавленных до вызова
+        void Flush();
+
+        // Записывает остаток очереди и останавливает поток; повторный вызов ничего не делает
+        void Stop();
+
+        RecordWriterStats GetStats() const noexcept;
+
+    private:
+        void Run();
+        size_t WriteBatch();
+
+        Sink sink_;
+        util::MpscQueue<PlayerRecord> queue_;
+        const size_t max_batch_;
+        const std::chrono::milliseconds flush_interval_;
+
+        std::vector<PlayerRecord> batch_;
+
+        std::counting_semaphore<> wake_{0};
+        std::atomic<bool> signaled_{false};
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> stopped_{false};
+
+        std::atomic<uint64_t> enqueued_{0};
+        std::atomic<uint64_t> processed_{0};
+        std::atomic<uint64_t> written_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<uint64_t> failed_{0};
+        std::atomic<uint64_t> batches_{0};
+        std::atomic<size_t> max_depth_{0};
+
+        std::mutex flush_mutex_;
+        std::condition_variable flushed_;
+
+        std::mutex stop_mutex_;
+        std::thread worker_;
+    };
+
+    struct LeaderboardStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        // Страницы за пределами хранимой части таблицы, прочитанные из базы
+        uint64_t fallbacks = 0;
+        uint64_t version = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    /*
+     *  Первые capacity строк hall_of_fame в памяти процесса в порядке выдачи рекордов.
+     *  Заполняется из базы при старте и дополняется рекордами после их записи.
+     *  Готовые JSON-страницы кешируются до следующего изменения таблицы.
+     */
+    class Leaderboard
+    {
+    public:
+        using Page = std::shared_ptr<const std::string>;
+        using PageSerializer = std::function<std::string(std::span<const PlayerRecord>)>;
+
+        static constexpr size_t kDefaultCapacity = 1000;
+        static constexpr size_t kMaxCachedPages = 64;
+
+        explicit Leaderboard(size_t capacity = kDefaultCapacity)
+            : capacity_{capacity} {};
+
+        Leaderboard(const Leaderboard &) = delete;
+        Leaderboard &operator=(const Leaderboard &) = delete;
+
+        // Порядок ORDER BY score DESC, play_time ASC, name ASC
+        static bool Precedes(const PlayerRecord &lhs, const PlayerRecord &rhs) noexcept;
+
+        size_t GetCapacity() const noexcept { return capacity_; }
+
+        // records - начало таблицы в порядке выдачи; complete - других строк в таблице нет
+        void Seed(std::vector<PlayerRecord> records, bool complete);
+
+        void Add(const std::vector<PlayerRecord> &records);
+
+        // nullptr, если страница выходит за хранимую часть таблицы и её нужно читать из базы
+        Page GetPage(size_t offset, size_t limit, const PageSerializer &serializer);
+
+        // Страница рекордов, следующих за cursor в порядке выдачи
+        Page GetPageAfter(const PlayerRecord &cursor, size_t limit, const PageSerializer &serializer);
+
+        LeaderboardStats GetStats() const;
+
+    private:
+        using PageKey = std::pair<size_t, size_t>;
+
+        Page GetPageLocked(std::unique_lock<std::mutex> &lock, size_t offset, size_t limit, const PageSerializer &serializer);
+        void Trim();
+
+        const size_t capacity_;
+
+        mutable std::mutex mutex_;
+        std::vector<PlayerRecord> records_;
+        bool complete_ = true;
+        uint64_t version_ = 0;
+        std::map<PageKey, Page> pages_;
+
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+        std::atomic<uint64_t> fallbacks_{0};
+    };
+
     class Database
     {
     public:
-        Database(const DatabasebConnectioSettings &db_settings) : connection_pool_(std::make_shared<ConnectionPool>(db_settings.number_of_connection,
-                                                                                                                    [db_url = std::move(db_settings.db_url)]()
-                                                                                                                    {
-                                                                                                                        return std::make_shared<pqxx::connection>(db_url);
-                                                                                                                    }))
+        Database(const DatabasebConnectioSettings &db_settings)
         {
-
-            auto conn = connection_pool_->GetConnection();
-            pqxx::work work_{*conn};
-            work_.exec(R"(
+            // Схема создаётся до пула: подготовленные выражения проверяются по существующей таблице
+            {
+                pqxx::connection conn{db_settings.db_url};
+                pqxx::work work_{conn};
+                work_.exec(R"(
 CREATE TABLE IF NOT EXISTS hall_of_fame (
     id SERIAL PRIMARY KEY,
     name varchar(40) NOT NULL,
     score integer CONSTRAINT score_positive CHECK (score >= 0),
     play_time integer NOT NULL CONSTRAINT play_time_positive CHECK (play_time >= 0)     
 );
-CREATE INDEX IF NOT EXISTS hall_of_fame_score ON hall_of_fame (score); 
+CREATE INDEX IF NOT EXISTS hall_of_fame_leaderboard ON hall_of_fame ((-score), play_time, name COLLATE "C") INCLUDE (score);
+DROP INDEX IF EXISTS hall_of_fame_score;
 )"_zv);
-            // коммитим изменения
-            work_.commit();
+                // коммитим изменения
+                work_.commit();
+            }
+
+            connection_pool_ = std::make_shared<ConnectionPool>(db_settings.number_of_connection,
+                                                                [db_url = db_settings.db_url]()
+                                                                {
+                                                                    auto conn = std::make_shared<pqxx::connection>(db_url);
+                                                                    PlayerRecordRepository::PrepareStatements(*conn);
+                                                                    return conn;
+                                                                },
+                                                                &CheckConnection);
+
+            // Одна лишняя строка показывает, поместилась ли таблица в память целиком
+            auto top = player_records_.GetRecordsTable(0, leaderboard_->GetCapacity() + 1);
+            const bool complete = top.size() <= leaderboard_->GetCapacity();
+            leaderboard_->Seed(std::move(top), complete);
+
+            record_writer_ = std::make_shared<RecordWriter>([pool = connection_pool_, leaderboard = leaderboard_](const std::vector<PlayerRecord> &records) mutable
+                                                            {
+                                                                PlayerRecordRepository{pool}.SavePlayerRecordsTable(records);
+                                                                leaderboard->Add(records); });
         }
 
         PlayerRecordRepository &GetPlayerRecords() & { return player_records_; }
 
+        // Очередь отложенной записи рекордов; общая для копий Database
+        RecordWriter &GetRecordWriter() & { return *record_writer_; }
+
+        // Таблица рекордов в памяти; общая для копий Database
+        Leaderboard &GetLeaderboard() & { return *leaderboard_; }
+
+        ConnectionPoolStats GetPoolStats() const { return connection_pool_->GetStats(); }
+
     private:
         std::shared_ptr<ConnectionPool> connection_pool_ = nullptr;
+        std::shared_ptr<Leaderboard> leaderboard_ = std::make_shared<Leaderboard>();
+        std::shared_ptr<RecordWriter> record_writer_ = nullptr;
         PlayerRecordRepository player_records_{connection_pool_};
     };
 
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+namespace util
+{
+    /*
+     *  Ячейки по номеру, которые создаются при первом обращении и больше не удаляются.
+     *  Уже созданная ячейка находится под разделяемой блокировкой; deque не переносит элементы при росте,
+     *  поэтому выданные ссылки остаются действительными и после добавления новых ячеек.
+     */
+    template <typename T>
+    class GrowOnlySlots
+    {
+    public:
+        GrowOnlySlots() = default;
+        GrowOnlySlots(const GrowOnlySlots &) = delete;
+        GrowOnlySlots &operator=(const GrowOnlySlots &) = delete;
+
+        // Недостающие ячейки до index включительно строятся из args
+        template <typename... Args>
+        T &Get(std::size_t index, const Args &...args)
+        {
+            {
+                std::shared_lock lock{mutex_};
+                if (index < slots_.size())
+                    return slots_[index];
+            }
+
+            std::unique_lock lock{mutex_};
+            while (slots_.size() <= index)
+                slots_.emplace_back(args...);
+            return slots_[index];
+        }
+
+    private:
+        std::shared_mutex mutex_;
+        std::deque<T> slots_;
+    };
+
+} // namespace util
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+namespace util
+{
+    /*
+     *  Лог-линейная гистограмма без блокировок (в духе HdrHistogram).
+     *  Каждая степень двойки делится на kSubBuckets равных корзин, поэтому относительная
+     *  погрешность квантилей не превышает 1 / kSubBuckets. Запись - несколько relaxed-атомиков.
+     */
+    class LogLinearHistogram
+    {
+    public:
+        static constexpr unsigned kSubBucketBits = 3;
+        static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+        static constexpr size_t kBucketsCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+        LogLinearHistogram() = default;
+        LogLinearHistogram(const LogLinearHistogram &) = delete;
+        LogLinearHistogram &operator=(const LogLinearHistogram &) = delete;
+
+        void Record(uint64_t value) noexcept
+        {
+            buckets_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        uint64_t GetCount() const noexcept
+        {
+            return count_.load(std::memory_order_relaxed);
+        }
+
+        uint64_t GetMax() const noexcept
+        {
+            return max_.load(std::memory_order_relaxed);
+        }
+
+        // Верхняя граница корзины, в которую попал квантиль q из [0, 1]; 0 для пустой гистограммы
+        uint64_t GetPercentile(double q) const noexcept
+        {
+            const uint64_t count = GetCount();
+            if (count == 0)
+                return 0;
+
+            const auto rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBucketsCount; ++i)
+            {
+                seen += buckets_[i].load(std::memory_order_relaxed);
+                if (seen >= rank)
+                    return std::min(UpperBoundOf(i), GetMax());
+            }
+            return GetMax();
+        }
+
+        // Добавляет записи другой гистограммы; используется для сводки по всем сессиям
+        void Merge(const LogLinearHistogram &other) noexcept
+        {
+            for (size_t i = 0; i < kBucketsCount; ++i)
+            {
+                if (const uint64_t n = other.buckets_[i].load(std::memory_order_relaxed); n != 0)
+                    buckets_[i].fetch_add(n, std::memory_order_relaxed);
+            }
+            count_.fetch_add(other.GetCount(), std::memory_order_relaxed);
+
+            const uint64_t other_max = other.GetMax();
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while (other_max > max && !max_.compare_exchange_weak(max, other_max, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void Reset() noexcept
+        {
+            for (auto &bucket : buckets_)
+                bucket.store(0, std::memory_order_relaxed);
+            count_.store(0, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+        static size_t BucketOf(uint64_t value) noexcept
+        {
+            if (value < kSubBuckets)
+                return static_cast<size_t>(value);
+
+            const unsigned exponent = 63 - std::countl_zero(value);
+            const uint64_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+            return static_cast<size_t>((exponent - kSubBucketBits + 1) * kSubBuckets + sub);
+        }
+
+        static uint64_t UpperBoundOf(size_t bucket) noexcept
+        {
+            if (bucket < kSubBuckets)
+                return bucket;
+
+            const unsigned exponent = static_cast<unsigned>(bucket / kSubBuckets) + kSubBucketBits - 1;
+            const uint64_t sub = bucket % kSubBuckets;
+            const uint64_t low = (kSubBuckets + sub) << (exponent - kSubBucketBits);
+            return low + ((uint64_t{1} << (exponent - kSubBucketBits)) - 1);
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, kBucketsCount> buckets_{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> max_{0};
+    };
+
+    /*
+     *  Записывает время жизни объекта в наносекундах в гистограмму.
+     *  С нулевым указателем часы не читаются, поэтому выключенное профилирование почти ничего не стоит.
+     */
+    class ScopedTimer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit ScopedTimer(LogLinearHistogram *histogram) noexcept
+            : histogram_{histogram}
+        {
+            if (histogram_ != nullptr)
+                start_ = Clock::now();
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        ~ScopedTimer()
+        {
+            if (histogram_ != nullptr)
+            {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_);
+                histogram_->Record(static_cast<uint64_t>(elapsed.count()));
+            }
+        }
+
+    private:
+        LogLinearHistogram *histogram_;
+        Clock::time_point start_;
+    };
+
+} // namespace util
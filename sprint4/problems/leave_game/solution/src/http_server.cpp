@@ -2,6 +2,7 @@
 #include "logging_request_handler.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <boost/beast/websocket.hpp>
 #include <boost/date_time.hpp>
 #include <iostream>
 
@@ -48,6 +49,11 @@ namespace http_server {
         if (ec) {
             return ReportError(ec, "read"sv);
         }
+
+        // Сокет переходит к обработчику Upgrade, HTTP-сессия на этом заканчивается
+        if (upgrade_handler_ && beast::websocket::is_upgrade(request_)) {
+            return upgrade_handler_(stream_.release_socket(), std::move(request_));
+        }
         
         HandleRequest(std::move(request_));
     }
@@ -9,6 +9,7 @@
 #include <boost/beast/http.hpp>
 
 #include <chrono>
+#include <functional>
 #include <iostream>
 
 #include <optional>
@@ -26,6 +27,9 @@ namespace http_server
 
     void ReportError(beast::error_code ec, std::string_view what);
 
+    // Забирает сокет у HTTP-сессии после запроса Upgrade (WebSocket)
+    using UpgradeHandler = std::function<void(tcp::socket &&socket, http::request<http::string_body> &&request)>;
+
     class SessionBase
     {
     public:
@@ -37,8 +41,8 @@ namespace http_server
         void Run();
 
     protected:
-        explicit SessionBase(tcp::socket &&socket)
-            : stream_(std::move(socket))
+        explicit SessionBase(tcp::socket &&socket, UpgradeHandler upgrade_handler = {})
+            : stream_(std::move(socket)), upgrade_handler_(std::move(upgrade_handler))
         {
         }
 
@@ -75,6 +79,7 @@ namespace http_server
         beast::tcp_stream stream_;
         beast::flat_buffer buffer_;
         HttpRequest request_;
+        UpgradeHandler upgrade_handler_;
     };
 
     template <typename RequestHandler>
@@ -82,8 +87,8 @@ namespace http_server
     {
     public:
         template <typename Handler>
-        Session(tcp::socket &&socket, Handler &&request_handler)
-            : SessionBase(std::move(socket)), request_handler_(std::forward<Handler>(request_handler))
+        Session(tcp::socket &&socket, Handler &&request_handler, UpgradeHandler upgrade_handler = {})
+            : SessionBase(std::move(socket), std::move(upgrade_handler)), request_handler_(std::forward<Handler>(request_handler))
         {
         }        
 
@@ -114,11 +119,11 @@ namespace http_server
 
     public:
         template <typename Handler>
-        Listener(net::io_context &ioc, const tcp::endpoint &endpoint, Handler &&request_handler)
+        Listener(net::io_context &ioc, const tcp::endpoint &endpoint, Handler &&request_handler, UpgradeHandler upgrade_handler = {})
             : ioc_(ioc)
               // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
               ,
-              acceptor_(net::make_strand(ioc)), request_handler_(std::forward<Handler>(request_handler))
+              acceptor_(net::make_strand(ioc)), request_handler_(std::forward<Handler>(request_handler)), upgrade_handler_(std::move(upgrade_handler))
         {
             // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
             acceptor_.open(endpoint.protocol());
@@ -176,22 +181,24 @@ namespace http_server
 
         void AsyncRunSession(tcp::socket &&socket)
         {
-            std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
+            std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_, upgrade_handler_)->Run();
         }
 
         net::io_context &ioc_;
         tcp::acceptor acceptor_;
         RequestHandler request_handler_;
+        UpgradeHandler upgrade_handler_;
     };
 
+    // upgrade_handler получает соединения, запросившие смену протокола; без него такие запросы обрабатываются как обычные
     template <typename RequestHandler>
-    void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler)
+    void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler, UpgradeHandler upgrade_handler = {})
     {
         // При помощи decay_t исключим ссылки из типа RequestHandler,
         // чтобы Listener хранил RequestHandler по значению
         using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-        std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+        std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), std::move(upgrade_handler))->Run();
     }
 
 } // namespace http_server
\ No newline at end of file
@@ -135,6 +135,30 @@ namespace json_loader
         
         double retirement_time = json::value_to<double>(value.at(kDogRetirementTime));
 
+        size_t default_max_loot_ = model::kDefaultMaxLoot;
+
+        if (value.as_object().if_contains(kDefaultMaxLoot))
+        {
+            default_max_loot_ = json::value_to<size_t>(value.at(kDefaultMaxLoot));
+        }
+
+        if (value.as_object().if_contains(kMaxPlayersPerSession))
+        {
+            game.SetMaxPlayersPerSession(json::value_to<size_t>(value.at(kMaxPlayersPerSession)));
+        }
+
+        // Максимальный шаг симуляции в миллисекундах
+        if (value.as_object().if_contains(kMaxTickStep))
+        {
+            game.SetMaxTickStep(std::chrono::milliseconds{json::value_to<uint64_t>(value.at(kMaxTickStep))});
+        }
+
+        // Фиксированное зерно делает появление собак и трофеев воспроизводимым
+        if (value.as_object().if_contains(kRandomSeed))
+        {
+            game.SetRandomSeed(json::value_to<uint64_t>(value.at(kRandomSeed)));
+        }
+
         auto maps = value.at("maps");
 
         for (const auto &map : maps.as_array())
@@ -161,6 +185,13 @@ namespace json_loader
                 map_bag_capacity_ = default_bag_capacity_;
             }
 
+            size_t map_max_loot_ = default_max_loot_;
+
+            if (map.as_object().if_contains(kMaxLoot))
+            {
+                map_max_loot_ = json::value_to<size_t>(map.at(kMaxLoot));
+            }
+
             std::string id = json::value_to<std::string>(map.at(kId));
             std::string name = json::value_to<std::string>(map.at(kName));
 
@@ -181,7 +212,9 @@ namespace json_loader
 
             new_map.SetDogSpeed(map_dog_speed_);
             new_map.SetBagCapacity(map_bag_capacity_);
-            new_map.SetRetirementTime(retirement_time);
+            // В конфиге время ухода задано в секундах, в модели - в миллисекундах
+            new_map.SetRetirementTime(static_cast<uint32_t>(retirement_time * model::kMillisecondsToSeconds));
+            new_map.SetMaxLoot(map_max_loot_);
 
             game.AddMap(std::move(new_map));
         }
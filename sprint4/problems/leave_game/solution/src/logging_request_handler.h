@@ -36,6 +36,8 @@ namespace server_logging
         using EmptyResponse = http::response<http::empty_body>;
         //
         using FileRequestResult = std::variant<EmptyResponse, StringResponse, FileResponse>;
+        // Ответ с общим телом (кеш состояния)
+        using SharedResponse = http::response<http_handler::SharedStringBody>;
 
     public:
 
@@ -58,7 +60,8 @@ namespace server_logging
             
             LogRequest(req);
 
-            decorated_(std::move(req), [this, start_ts_, &send](auto&& res)
+            // send копируется: ответ может быть отправлен из strand уже после выхода из operator()
+            decorated_(std::move(req), [this, start_ts_, send = std::forward<Send>(send)](auto&& res)
             {
                 auto end_ts_ = std::chrono::system_clock::now();
                 auto diff = duration_cast<std::chrono::milliseconds>(end_ts_ - start_ts_);
@@ -143,6 +146,17 @@ namespace server_logging
             BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, custom_data) << "response sent"sv;   
         }
 
+        void LogResponse(const SharedResponse& r, const int64_t& time)
+        {
+            boost::json::value custom_data
+            {
+                {"response_time"s, time}, 
+                {"code"s, static_cast<uint32_t>(r.base().result())}, 
+                {"content_type"s, r[http::field::content_type]}
+            };
+            BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, custom_data) << "response sent"sv;
+        }
+
         void LogResponse(const StringResponse& r, const int64_t& time)
         {
            std::string_view content_type = "";
@@ -35,6 +35,14 @@ public:
      */
     unsigned Generate(TimeInterval time_delta, unsigned loot_count, unsigned looter_count);
 
+    TimeInterval GetBaseInterval() const noexcept {
+        return base_interval_;
+    }
+
+    double GetProbability() const noexcept {
+        return probability_;
+    }
+
 private:
     static double DefaultGenerator() noexcept {
         return 1.0;
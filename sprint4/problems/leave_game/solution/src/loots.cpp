@@ -16,6 +16,14 @@ namespace add_data
         }
     }
 
+    const std::vector<Loot> &GameLoots::GetLootTypes(const std::string &map_name) const
+    {
+        static const std::vector<Loot> empty;
+
+        auto pos = loot_.find(map_name);
+        return pos == loot_.end() ? empty : pos->second;
+    }
+
     void GameLoots::AddLoot(const std::string &map_name, Loot &&new_loot)
     {
         auto it = loot_.find(map_name);
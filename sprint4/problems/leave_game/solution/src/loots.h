@@ -35,6 +35,9 @@ namespace add_data
         GameLoots() = default;
 
         std::vector<Loot> GetLoot(const std::string &map_name);
+
+        // Типы трофеев карты без копирования; пустой список, если карта неизвестна
+        const std::vector<Loot> &GetLootTypes(const std::string &map_name) const;
         void AddLoot(const std::string &map_name, Loot&& new_loot);
 
         void MakeGenerator(loot_gen::LootGenerator& gen)
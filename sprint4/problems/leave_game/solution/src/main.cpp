@@ -61,6 +61,8 @@ struct Args
 {
     size_t tick_period;
     size_t save_tick_period;
+    unsigned tick_threads = 1;
+    size_t max_catch_up_steps = app::kDefaultMaxCatchUpSteps;
     std::filesystem::path config_file;
     std::filesystem::path www_root;
     std::filesystem::path state_file;
@@ -87,6 +89,10 @@ struct Args
         "Set save files");
     add("save-state-period,ssp", po::value<size_t>(&args.save_tick_period),
         "Set save state period");
+    add("tick-threads", po::value<unsigned>(&args.tick_threads),
+        "Set number of threads simulating game sessions during a tick");
+    add("max-catch-up-steps", po::value<size_t>(&args.max_catch_up_steps),
+        "Set max number of missed ticks simulated after a delay");
 
     // variables_map хранит значения опций после разбора
     po::variables_map vm;
@@ -153,6 +159,7 @@ int main(int argc, const char *argv[])
                           args->config_file);
 
         game.AddDb(std::make_shared<database::Database>(db_));
+        game.SetTickThreads(args->tick_threads);
         
         app::Players players;
         app::Application application{game, players, args->state_file,
@@ -183,7 +190,12 @@ int main(int argc, const char *argv[])
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
 
-        http_server::ServeHttp(ioc, {address, port}, logger_handler);
+        // Запросы Upgrade (WebSocket-подписка на состояние) обработчик забирает вместе с сокетом
+        http_server::ServeHttp(ioc, {address, port}, logger_handler,
+                               [handler](net::ip::tcp::socket &&socket, http::request<http::string_body> &&req)
+                               {
+                                   handler->Upgrade(std::move(socket), std::move(req));
+                               });
         // Эта надпись сообщает тестам о том, что сервер запущен и готов
         // обрабатывать запросы
 
@@ -204,7 +216,10 @@ int main(int argc, const char *argv[])
                 if (!ec)
                 {
                     json::value custom_data_stop{{"code"s, 0}};
-                    application.SaveGame();
+                    {
+                        const auto lock = application.LockExclusive();
+                        application.SaveGame();
+                    }
                     BOOST_LOG_TRIVIAL(info)
                         << boost::log::add_value(additional_data, custom_data_stop)
                         << "server exited"sv;
@@ -221,15 +236,32 @@ int main(int argc, const char *argv[])
             {
                 if (!game.IsDebug())
                 {
+                    const auto lock = application.LockExclusive();
                     game.Tick(delta, game_loots);
-                    application.SaveGameState(delta);
                 }
-            });
+            },
+            args->max_catch_up_steps, &application.GetTickStats());
+        // Уборка ушедших, сохранение и рассылка - один раз за срабатывание, сколько бы шагов ни догонялось
+        ticker->SetAfterSteps([&game, &application, handler](std::chrono::milliseconds elapsed)
+                              {
+                                  if (game.IsDebug())
+                                      return;
+
+                                  {
+                                      const auto lock = application.LockExclusive();
+                                      application.RemoveRetiredPlayers();
+                                      application.SaveGameState(elapsed);
+                                  }
+                                  // Снимки уже опубликованы, рассылка подписчикам не держит блокировку игры
+                                  handler->PublishState(); });
         ticker->Start();
 
         // 6. Запускаем обработку асинхронных операций
         RunWorkers(std::max(1u, num_threads), [&ioc]
                    { ioc.run(); });
+
+        // Тики остановлены, дописываем рекорды из очереди
+        db_.GetRecordWriter().Stop();
     }
     catch (const std::exception &ex)
     {
@@ -2,42 +2,19 @@
 #include "loots.h"
 #include "loot_generator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <latch>
 #include <stdexcept>
 #include <functional>
+#include <unordered_set>
 
 namespace model
 {
 
     using namespace std::literals;
 
-void Dog::UpdateInactionTime(std::chrono::milliseconds time)
-        {
-            if (inaction_)
-            {
-                afk_time_ += time.count();
-            }
-        }
-
-        void Dog::SetInaction(bool value)
-        {
-            inaction_ = value;
-
-            if (inaction_ == false)
-                afk_time_ = 0;
-        }
-
-    void Dog::SetPosition(const double &x, const double &y)
-    {
-        position_.x = x;
-        position_.y = y;
-    }
-
-    void Dog::SetSpeed(const int32_t &x, const int32_t &y)
-    {
-        speed_.x = x;
-        speed_.y = y;
-    }
-
     template <typename T>
     bool IsInBounds(const T &value, T low, T high)
     {
@@ -47,223 +24,375 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         return (value >= low) && (value <= high);
     }
 
-    void Dog::UpdateHorizontal(const Road &&road, const double &x)
+    namespace
     {
-        double start = road.GetStart().x;
-        double end = road.GetEnd().x;
+        // Переводит число из [0, 1) в целое из [start, end]
+        int32_t ScaleToRange(double unit, int32_t start, int32_t end) noexcept
+        {
+            if (start > end)
+                std::swap(start, end);
 
-        if (start > end)
-            std::swap(start, end);
+            const auto offset = static_cast<int64_t>(unit * (static_cast<double>(end) - start + 1));
+            return static_cast<int32_t>(std::min<int64_t>(start + offset, end));
+        }
 
-        if (IsInBounds<double>(x, start, end))
+        // Разные зёрна для сессий одной игры из общего зерна конфигурации
+        uint64_t MixSeed(uint64_t seed, uint64_t session_index) noexcept
         {
-            position_.x = x;
+            return seed ^ (session_index * 0x9e3779b97f4a7c15ULL);
         }
-        else
+    } // namespace
+
+    namespace
+    {
+        bool IsHorizontal(Direction direction) noexcept
         {
-            if (x > end)
-            {
-                position_.x = end + kRoadWidth;
-            }
-            else
-            {
-                position_.x = start - kRoadWidth;
-            }
+            return direction == Direction::WEST || direction == Direction::EAST;
+        }
 
-            speed_.x = 0;
-            speed_.y = 0;
+        bool IsVertical(Direction direction) noexcept
+        {
+            return direction == Direction::NORTH || direction == Direction::SOUTH;
         }
-    }
+    } // namespace
 
-    void Dog::UpdateVertical(const Road &&road, const double &y)
+    DogStore::Slot DogStore::Add(const State &state)
     {
-        double start = road.GetStart().y;
-        double end = road.GetEnd().y;
+        const size_t index = Size();
 
-        if (start > end)
-            std::swap(start, end);
-
-        if (IsInBounds<double>(y, start, end))
+        Slot slot;
+        if (!free_slots_.empty())
         {
-            position_.y = y;
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            slot_to_index_[slot] = index;
         }
         else
         {
-            if (y > end)
-            {
-                position_.y = end + kRoadWidth;
-            }
-            else
-            {
-                position_.y = start - kRoadWidth;
-            }
+            slot = static_cast<Slot>(slot_to_index_.size());
+            slot_to_index_.push_back(index);
+            slot_generations_.push_back(0);
+            idle_epochs_.push_back(0);
+        }
 
-            speed_.x = 0;
-            speed_.y = 0;
+        positions_.push_back(state.position);
+        start_positions_.push_back(state.position);
+        speeds_.push_back(state.speed);
+        directions_.push_back(state.direction);
+        segments_.push_back(state.segment);
+        idle_since_.push_back(now_);
+        joined_at_.push_back(now_ - state.play_time);
+        inaction_.push_back(false);
+        index_to_slot_.push_back(slot);
+
+        if (state.inaction)
+            StartIdle(index, now_ - state.afk_time);
+
+        return slot;
+    }
+
+    void DogStore::Remove(Slot slot)
+    {
+        const size_t index = slot_to_index_[slot];
+        const size_t last = Size() - 1;
+
+        if (index != last)
+        {
+            positions_[index] = positions_[last];
+            start_positions_[index] = start_positions_[last];
+            speeds_[index] = speeds_[last];
+            directions_[index] = directions_[last];
+            segments_[index] = segments_[last];
+            idle_since_[index] = idle_since_[last];
+            joined_at_[index] = joined_at_[last];
+            inaction_[index] = inaction_[last];
+
+            const Slot moved = index_to_slot_[last];
+            index_to_slot_[index] = moved;
+            slot_to_index_[moved] = index;
         }
+
+        positions_.pop_back();
+        start_positions_.pop_back();
+        speeds_.pop_back();
+        directions_.pop_back();
+        segments_.pop_back();
+        idle_since_.pop_back();
+        joined_at_.pop_back();
+        inaction_.pop_back();
+        index_to_slot_.pop_back();
+
+        // Старые ссылки и таймеры слота перестают совпадать по поколению
+        slot_to_index_[slot] = kFreeSlot;
+        ++slot_generations_[slot];
+        free_slots_.push_back(slot);
+    }
+
+    DogStore::State DogStore::GetState(size_t index) const noexcept
+    {
+        return {positions_[index], speeds_[index], directions_[index], segments_[index],
+                GetAfkTime(index), GetPlayTime(index), static_cast<bool>(inaction_[index])};
     }
 
-    void Dog::Tick(std::chrono::milliseconds time, const model::Map &map)
+    void DogStore::StartIdle(size_t index, int64_t idle_since)
     {
+        const Slot slot = index_to_slot_[index];
+
+        inaction_[index] = true;
+        idle_since_[index] = idle_since;
+        ++idle_epochs_[slot];
+        idle_timers_.Schedule(idle_since + retirement_time_ + 1, IdleTimer{slot, slot_generations_[slot], idle_epochs_[slot]});
+    }
+
+    void DogStore::SetInaction(size_t index, bool value)
+    {
+        if (value == static_cast<bool>(inaction_[index]))
+            return;
+
+        if (value)
+            StartIdle(index, now_);
+        else
+            inaction_[index] = false;
+    }
+
+    void DogStore::Move(std::chrono::milliseconds time, const Map &map)
+    {
+        std::copy(positions_.begin(), positions_.end(), start_positions_.begin());
+
         if (time.count() == 0)
             return;
 
-        SetPlayTime(time.count());
+        const size_t count = Size();
+        const double time_diff = static_cast<double>(time.count()) / kMillisecondsToSeconds;
 
-        double time_diff_ = time.count() / kMillisecondsToSeconds;
+        next_x_.resize(count);
+        next_y_.resize(count);
 
-        double x = position_.x + speed_.x * time_diff_;
-        double y = position_.y + speed_.y * time_diff_;
+        // Интегрирование: один проход по непрерывным массивам без ветвлений
+        for (size_t i = 0; i < count; ++i)
+        {
+            next_x_[i] = positions_[i].x + speeds_[i].x * time_diff;
+            next_y_[i] = positions_[i].y + speeds_[i].y * time_diff;
+        }
 
-        /*
-        TO DO.
-        Чтобы быстро находить участок дороги по координатам, построить вспомогательную структуру данных, чтобы вместо
-        линейного перебора всех дорог на карте искать дороги внутри map, unordered_map или отсортированного vector.
-        */
-        auto roads_ = map.GetRoads();
-        std::vector<Road> vec_road;
-        for (auto &road : roads_)
+        // Обрезка движения по графу дорог
+        const RoadGraph &graph = map.GetRoadGraph();
+        for (size_t i = 0; i < count; ++i)
         {
-            auto check_x_ = IsInBounds<int>(std::round(position_.x), road.GetStart().x, road.GetEnd().x);
-            auto check_y_ = IsInBounds<int>(std::round(position_.y), road.GetStart().y, road.GetEnd().y);
+            MoveAlongRoad(i, graph, map, next_x_[i], next_y_[i]);
+        }
 
-            if (!check_x_ || !check_y_)
-                continue;
+        // Остановившиеся в этом тике собаки бездействуют с его начала
+        now_ += time.count();
+    }
 
-            vec_road.push_back(road);
-        }
+    uint32_t DogStore::LocateSegment(size_t index, const Map &map) const noexcept
+    {
+        const Position &position = positions_[index];
+        const Point cell{static_cast<Coord>(std::round(position.x)), static_cast<Coord>(std::round(position.y))};
+        const bool horizontal = IsHorizontal(directions_[index]);
+
+        const Road *road = map.FindRoadAt(cell, horizontal);
+        if (road == nullptr)
+            road = map.FindRoadAt(cell, !horizontal);
+        if (road == nullptr)
+            return kNoSegment;
+
+        return map.GetRoadGraph().SegmentOfRoad(static_cast<size_t>(road - map.GetRoads().data()));
+    }
+
+    void DogStore::MoveAlongRoad(size_t index, const RoadGraph &graph, const Map &map, double x, double y)
+    {
+        const Direction direction = directions_[index];
+        const bool horizontal = IsHorizontal(direction);
 
-        if (vec_road.empty())
+        if (!horizontal && !IsVertical(direction))
             return;
 
-        for (const auto &road : vec_road)
+        uint32_t segment = segments_[index];
+        if (segment == kNoSegment)
         {
-            bool p1 = road.IsHorizontal();
-            bool p2 = direction_ == kLeftDirection || direction_ == kRightDirection;
-
-            if (p1 && p2)
-            {
-                UpdateHorizontal(std::move(road), x);
-                UpdateRoad(road);
+            segment = LocateSegment(index, map);
+            if (segment == kNoSegment)
                 return;
-            }
+            segments_[index] = segment;
+        }
 
-            p1 = road.IsVertical();
-            p2 = direction_ == kUpDirection || direction_ == kDownDirection;
+        Position &position = positions_[index];
+        double &coord = horizontal ? position.x : position.y;
+        const double next = horizontal ? x : y;
 
-            if (p1 && p2)
+        if (graph.GetSegment(segment).horizontal != horizontal)
+        {
+            // Свернуть можно только на перекрёстке, где есть отрезок нужного направления
+            const auto &current = graph.GetSegment(segment);
+            const auto along = static_cast<int>(std::round(current.horizontal ? position.x : position.y));
+            const auto node = graph.FindNodeOnSegment(segment, along);
+            const auto turn = node == RoadGraph::kNone
+                                  ? RoadGraph::kNone
+                                  : (horizontal ? graph.GetNode(node).horizontal : graph.GetNode(node).vertical);
+
+            if (turn == RoadGraph::kNone)
             {
-                UpdateVertical(std::move(road), y);
-                UpdateRoad(road);
+                const double low = current.line - kRoadWidth;
+                const double high = current.line + kRoadWidth;
+                if (IsInBounds<double>(next, low, high))
+                {
+                    coord = next;
+                }
+                else
+                {
+                    coord = std::clamp(next, low, high);
+                    Stop(index);
+                    SetInaction(index, true);
+                }
                 return;
             }
+
+            segment = turn;
+            segments_[index] = segment;
         }
 
-        if (direction_ == kLeftDirection)
-        {
+        const auto &road = graph.GetSegment(segment);
+        const double start = road.from;
+        const double end = road.to;
 
-            if (x < static_cast<int64_t>(std::round(position_.x) - kRoadWidth))
-            {
-                position_.x = std::round(position_.x) - kRoadWidth;
-                speed_.x = 0;
-                speed_.y = 0;
-                SetInaction(true);
-            }
-            else
-            {
-                position_.x = x;
-            }
-        }
-        else if (direction_ == kRightDirection)
+        if (IsInBounds<double>(next, start, end))
         {
-            if (x > static_cast<int64_t>(std::round(position_.x) + kRoadWidth))
-            {
-                position_.x = std::round(position_.x) + kRoadWidth;
-                speed_.x = 0;
-                speed_.y = 0;
-                SetInaction(true);
-            }
-            else
-            {
-                position_.x = x;
-            }
+            coord = next;
         }
-        else if (direction_ == kUpDirection)
+        else
         {
-            if (y < static_cast<int64_t>(std::round(position_.y) - kRoadWidth))
-            {
-                position_.y = std::round(position_.y) - kRoadWidth;
-                speed_.x = 0;
-                speed_.y = 0;
-                SetInaction(true);
-            }
-            else
-            {
-                position_.y = y;
-            }
+            coord = next > end ? end + kRoadWidth : start - kRoadWidth;
+            Stop(index);
         }
-        else if (direction_ == kDownDirection)
+    }
+
+    void Dog::Attach(DogStore &store)
+    {
+        slot_ = store.Add(state_);
+        store_ = &store;
+    }
+
+    void Dog::Detach() noexcept
+    {
+        if (!store_)
+            return;
+
+        state_ = store_->GetState(Index());
+        store_ = nullptr;
+    }
+
+    void Dog::SetInaction(bool value)
+    {
+        if (store_)
         {
-            if (y > static_cast<int64_t>(std::round(position_.y) + kRoadWidth))
-            {
-                position_.y = std::round(position_.y) + kRoadWidth;
-                speed_.x = 0;
-                speed_.y = 0;
+            store_->SetInaction(Index(), value);
+            return;
+        }
 
-                SetInaction(true);
-            }
-            else
-            {
-                position_.y = y;
-            }
+        state_.inaction = value;
+
+        if (state_.inaction == false)
+            state_.afk_time = 0;
+    }
+
+    void Dog::SetPlayTime(int64_t play_time)
+    {
+        if (store_)
+            store_->SetPlayTime(Index(), play_time);
+        else
+            state_.play_time = play_time;
+    }
+
+    void Dog::SetPosition(const double &x, const double &y)
+    {
+        if (store_)
+            store_->SetPosition(Index(), {x, y});
+        else
+            state_.position = {x, y};
+    }
+
+    void Dog::SetSpeed(const int32_t &x, const int32_t &y)
+    {
+        const Speed speed{static_cast<float>(x), static_cast<float>(y)};
+
+        if (store_)
+            store_->SetSpeed(Index(), speed);
+        else
+            state_.speed = speed;
+    }
+
+    void Dog::SetRoadSegment(uint32_t segment) noexcept
+    {
+        if (store_)
+            store_->SetSegment(Index(), segment);
+        else
+            state_.segment = segment;
+    }
+
+    const std::string &Dog::GetDirection() const noexcept
+    {
+        switch (GetDirectionType())
+        {
+        case Direction::WEST:
+            return kLeftDirection;
+        case Direction::EAST:
+            return kRightDirection;
+        case Direction::NORTH:
+            return kUpDirection;
+        case Direction::SOUTH:
+            return kDownDirection;
+        default:
+            return kNoDirection;
         }
     }
 
     void Dog::SetDirection(const std::string &direction, size_t current_speed_)
     {
-        direction_ = direction;
+        const auto speed = static_cast<int32_t>(current_speed_);
+        Direction new_direction;
 
-        if (direction_ == kLeftDirection)
+        if (direction == kLeftDirection)
         {
+            new_direction = Direction::WEST;
             SetInaction(false);
-            SetSpeed(-current_speed_, 0);
+            SetSpeed(-speed, 0);
         }
-        else if (direction_ == kRightDirection)
+        else if (direction == kRightDirection)
         {
+            new_direction = Direction::EAST;
             SetInaction(false);
-            SetSpeed(current_speed_, 0);
+            SetSpeed(speed, 0);
         }
-        else if (direction_ == kUpDirection)
+        else if (direction == kUpDirection)
         {
+            new_direction = Direction::NORTH;
             SetInaction(false);
-            SetSpeed(0, -current_speed_);
+            SetSpeed(0, -speed);
         }
-        else if (direction_ == kDownDirection)
+        else if (direction == kDownDirection)
         {
+            new_direction = Direction::SOUTH;
             SetInaction(false);
-            SetSpeed(0, current_speed_);
+            SetSpeed(0, speed);
         }
-        else if (direction_.empty())
+        else if (direction.empty())
         {
+            new_direction = Direction::NONE;
             SetInaction(true);
             SetSpeed(0, 0);
         }
-    }
-
-    void Dog::UpdateRoad(const Road &road)
-    {
-        if (current_road_ == nullptr)
-        {
-            current_road_ = std::make_shared<Road>(road);
-            return;
-        }
-
-        if (*current_road_.get() == road)
+        else
         {
+            // Неизвестное направление игнорируем
             return;
         }
 
-        *current_road_ = road;
+        if (store_)
+            store_->SetDirection(Index(), new_direction);
+        else
+            state_.direction = new_direction;
     }
 
     void Dog::AddItemToBag(MapLoot &&item)
@@ -302,11 +431,6 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         return bag_;
     }
 
-    std::shared_ptr<Road> Dog::GetRoad() const noexcept
-    {
-        return current_road_;
-    }
-
     void Game::AddMap(Map &&map)
     {
         const size_t index = maps_.size();
@@ -318,7 +442,8 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         {
             try
             {
-                maps_.emplace_back(std::move(map));
+                map.BuildRoadGraph();
+                maps_.emplace_back(std::make_shared<const Map>(std::move(map)));
             }
             catch (...)
             {
@@ -339,7 +464,13 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         {
             try
             {
+                auto &map_sessions = map_id_to_sessions_[game_session->GetMap().GetId()];
+                map_sessions.reserve(map_sessions.size() + 1);
+                game_session->SetIndex(static_cast<uint32_t>(index));
+                game_session->SetProfiling(profiling_);
                 game_sessions_.emplace_back(std::move(game_session));
+                map_sessions.push_back(index);
+                published_sessions_.Store(std::make_shared<const std::vector<std::shared_ptr<const GameSession>>>(game_sessions_.begin(), game_sessions_.end()));
             }
             catch (...)
             {
@@ -350,20 +481,128 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         }
     }
 
+    void Game::SetTickThreads(unsigned threads)
+    {
+        tick_threads_ = std::max(1u, threads);
+        tick_pool_ = tick_threads_ > 1 ? std::make_shared<boost::asio::thread_pool>(tick_threads_) : nullptr;
+    }
+
+    void Game::SetProfiling(bool enabled) noexcept
+    {
+        profiling_ = enabled;
+        for (auto &game_session : game_sessions_)
+        {
+            game_session->SetProfiling(enabled);
+        }
+    }
+
+    void Game::ResetProfile() noexcept
+    {
+        for (auto &histogram : *profile_)
+        {
+            histogram.Reset();
+        }
+        for (auto &game_session : game_sessions_)
+        {
+            game_session->ResetProfile();
+        }
+    }
+
     void Game::Tick(std::chrono::milliseconds time, add_data::GameLoots &game_loots)
     {
+        Tick(time, game_loots, db_->GetRecordWriter());
+    }
+
+    void Game::Tick(std::chrono::milliseconds time, add_data::GameLoots &game_loots, database::RecordWriter &records)
+    {
+        util::ScopedTimer timer{ProfileOf(TickPhase::TICK)};
+
+        if (max_tick_step_.count() > 0)
+        {
+            for (; time > max_tick_step_; time -= max_tick_step_)
+            {
+                TickStep(max_tick_step_, game_loots, records);
+            }
+        }
+
+        if (time.count() > 0)
+        {
+            TickStep(time, game_loots, records);
+        }
+
+        for (auto &game_session : game_sessions_)
+        {
+            game_session->PublishTick();
+        }
+    }
+
+    std::vector<DogHandle> Game::TakeRetiredDogs()
+    {
+        std::vector<DogHandle> retired;
         for (auto &game_session : game_sessions_)
-        {            
-            game_session->LootGenerator(game_loots, time);
-            game_session->Tick(time, db_->GetPlayerRecords());
-            game_session->FindCollision();
+        {
+            auto session_retired = game_session->TakeRetired();
+            retired.insert(retired.end(), session_retired.begin(), session_retired.end());
+        }
+        return retired;
+    }
+
+    void Game::TickStep(std::chrono::milliseconds time, add_data::GameLoots &game_loots, database::RecordWriter &records)
+    {
+        auto tick_session = [time, &game_loots, &records](GameSession &game_session)
+        {
+            {
+                util::ScopedTimer timer{game_session.ProfileOf(TickPhase::LOOT_GENERATION)};
+                game_session.LootGenerator(game_loots, time);
+            }
+            game_session.Tick(time, records);
+            {
+                util::ScopedTimer timer{game_session.ProfileOf(TickPhase::COLLISION)};
+                game_session.FindCollision();
+            }
+        };
+
+        if (tick_pool_ == nullptr || game_sessions_.size() < 2)
+        {
+            for (auto &game_session : game_sessions_)
+            {
+                tick_session(*game_session);
+            }
+            return;
+        }
+
+        // Каждая сессия считается в пуле потоков, барьер дожидается всех до публикации тика
+        std::vector<std::exception_ptr> errors(game_sessions_.size());
+        std::latch done{static_cast<std::ptrdiff_t>(game_sessions_.size())};
+
+        for (size_t i = 0; i < game_sessions_.size(); ++i)
+        {
+            boost::asio::post(*tick_pool_, [&, i]
+                              {
+                                  try
+                                  {
+                                      tick_session(*game_sessions_[i]);
+                                  }
+                                  catch (...)
+                                  {
+                                      errors[i] = std::current_exception();
+                                  }
+                                  done.count_down(); });
+        }
+
+        done.wait();
+
+        for (const auto &error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
         }
     }
 
     void Game::DisconnectSession(GameSession *game_session_, Dog *dog_)
     {
+        // Собаками владеет сессия, удалять объект здесь нельзя
         game_session_->DeleteDog(dog_->GetId());
-        delete dog_;
     }
 
     void GameSession::SetPositionDog(std::shared_ptr<Dog> &dog, const bool default_spawn)
@@ -371,28 +610,32 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         if (default_spawn)
         {
             dog->SetPosition(0, 0);
-            dog->UpdateRoad(map_.GetRoads().at(0));
+            dog->SetRoadSegment(DogStore::kNoSegment);
         }
         else
         {
-            auto roads = map_.GetRoads();
-            auto road = roads.at(GenerateNum(1, roads.size()));
-            auto x = GenerateNum(road.GetStart().x, road.GetEnd().x);
-            auto y = GenerateNum(road.GetStart().y, road.GetEnd().y);
+            const auto &roads = map_->GetRoads();
+            if (roads.empty())
+                return;
+
+            const auto road_index = random_.NextInt(0, static_cast<int32_t>(roads.size()) - 1);
+            const auto &road = roads[road_index];
+            auto x = random_.NextInt(road.GetStart().x, road.GetEnd().x);
+            auto y = random_.NextInt(road.GetStart().y, road.GetEnd().y);
 
             dog->SetPosition(x, y);
-            dog->UpdateRoad(road);
+            dog->SetRoadSegment(map_->GetRoadGraph().SegmentOfRoad(road_index));
         }
     }
 
-    void GameSession::AddDog(std::shared_ptr<Dog> &dog, const bool default_spawn)
+    DogHandle GameSession::AddDog(std::shared_ptr<Dog> &dog, const bool default_spawn)
     {
         SetPositionDog(dog, default_spawn);
 
-        AddDog(dog);
+        return AddDog(dog);
     }
 
-    void GameSession::AddDog(std::shared_ptr<Dog> &dog)
+    DogHandle GameSession::AddDog(std::shared_ptr<Dog> &dog)
     {
         const size_t index = dogs_.size();
         if (auto [it, inserted] = dog_id_to_index_.emplace(dog->GetId(), index); !inserted)
@@ -403,6 +646,8 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         {
             try
             {
+                dogs_.reserve(index + 1);
+                dog->Attach(dog_store_);
                 dogs_.emplace_back(std::move(dog));
             }
             catch (...)
@@ -411,186 +656,436 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
                 throw;
             }
         }
+
+        // Новый игрок виден в состоянии сразу, не дожидаясь тика
+        PublishSnapshot();
+        return GetHandle(*dogs_[index]);
     }
 
-    std::shared_ptr<Dog> GameSession::FindDog(const Dog::Id &id) noexcept
+    void GameSession::DeleteDog(const Dog::Id &id)
     {
         if (auto it = dog_id_to_index_.find(id); it != dog_id_to_index_.end())
         {
-            return dogs_.at(it->second);
+            RemoveDogAt(it->second);
+            PublishSnapshot();
         }
-        return nullptr;
     }
 
-    void GameSession::Tick(std::chrono::milliseconds time, database::PlayerRecordRepository& player_rep_)
+    namespace
     {
-        for (auto &dog_ : dogs_)
+        // Изменения от снимка from к снимку to
+        std::shared_ptr<SessionDelta> MakeDelta(const SessionSnapshot &from, const SessionSnapshot &to)
         {
-            dog_->Tick(time, GetMap());
+            auto delta = std::make_shared<SessionDelta>();
+            delta->tick = to.tick;
+
+            std::unordered_map<DogStore::Slot, const DogSnapshot *> previous_dogs;
+            previous_dogs.reserve(from.dogs.size());
+            for (const auto &dog : from.dogs)
+                previous_dogs.emplace(dog.handle.slot, &dog);
+
+            std::unordered_map<int, const MapLoot *> previous_loots;
+            previous_loots.reserve(from.loots.size());
+            for (const auto &loot : from.loots)
+                previous_loots.emplace(loot.id_, &loot);
 
-            if (dog_->isAfk())
+            for (const auto &dog : to.dogs)
             {
-                dog_->UpdateInactionTime(time);
+                const auto it = previous_dogs.find(dog.handle.slot);
+                if (it == previous_dogs.end() || !(*it->second == dog))
+                    delta->changed_dogs.push_back(dog);
+                if (it != previous_dogs.end() && it->second->handle == dog.handle)
+                    previous_dogs.erase(it);
+            }
+            for (const auto &[slot, dog] : previous_dogs)
+                delta->removed_dogs.push_back(dog->handle);
 
-                if (map_.GetRetirementTime() < dog_->GetRetirementTime())
-                {
-                    database::PlayerRecord record(*dog_->GetId(), dog_->GetScore(), (dog_->GetPlayTime() - dog_->GetRetirementTime()));
-                    player_rep_.SavePlayerRecord(record);
-                }
+            for (const auto &loot : to.loots)
+            {
+                const auto it = previous_loots.find(loot.id_);
+                if (it == previous_loots.end() || !(*it->second == loot))
+                    delta->changed_loots.push_back(loot);
+                if (it != previous_loots.end())
+                    previous_loots.erase(it);
             }
+            for (const auto &[id, loot] : previous_loots)
+                delta->removed_loots.push_back(id);
+
+            return delta;
         }
     }
 
-    void GameSession::LootGenerator(add_data::GameLoots &game_loots, std::chrono::milliseconds delta)
+    std::shared_ptr<SessionSnapshot> GameSession::MakeSnapshot() const
     {
-        auto current_map_loot = map_.GetLoots();
-        auto all_loot = game_loots.GetLoot(map_.GetName());
+        auto snapshot = std::make_shared<SessionSnapshot>();
 
-        for (size_t i = 0; i < map_.GetRoads().size(); ++i)
+        snapshot->dogs.reserve(dogs_.size());
+        for (const auto &dog : dogs_)
         {
-            auto roads = map_.GetRoads();
-            auto road = roads.at(i);
-            auto x = GenerateNum(road.GetStart().x, road.GetEnd().x);
-            auto y = GenerateNum(road.GetStart().y, road.GetEnd().y);
-            auto type = GenerateNum(0, all_loot.size() - 1);
+            snapshot->dogs.push_back({GetHandle(*dog), *dog->GetId(), dog->GetPosition(), dog->GetSpeed(),
+                                      dog->GetDirection(), dog->GetBag(), dog->GetScore()});
+        }
 
-            MapLoot new_map_loot(num_loot_++, all_loot.at(type).value_, type, x, y);
-            map_.AddLoot(new_map_loot);
+        const auto &loots = map_state_.GetLoots();
+        snapshot->loots.reserve(loots.Size());
+        for (const auto &loot : loots)
+        {
+            snapshot->loots.push_back(loot);
         }
+
+        return snapshot;
     }
 
-    void GameSession::FindCollision()
+    void GameSession::PublishTick()
     {
-        collision_detector::Provider provider{};
+        auto snapshot = MakeSnapshot();
+        snapshot->tick = tick_snapshot_->tick + 1;
+
+        // Дельта тика считается от конца прошлого тика и включает вход и выход собак между тиками
+        const auto &history = tick_snapshot_->history;
+        const size_t kept = std::min(history.size(), kStateHistoryWindow - 1);
+        snapshot->history.reserve(kept + 1);
+        snapshot->history.assign(history.end() - kept, history.end());
+        snapshot->history.push_back(MakeDelta(*tick_snapshot_, *snapshot));
+
+        tick_snapshot_ = snapshot;
+        snapshot_.Store(std::move(snapshot));
+    }
 
-        for (const auto &dog : dogs_)
-        {
-            std::string id_str = *dog->GetId();
-            double curr_position_x = dog->GetPosition().x;
-            double curr_position_y = dog->GetPosition().y;
+    void GameSession::PublishSnapshot()
+    {
+        auto snapshot = MakeSnapshot();
+        snapshot->tick = tick_snapshot_->tick;
+        snapshot->history = tick_snapshot_->history;
+        snapshot->pending = MakeDelta(*tick_snapshot_, *snapshot);
+
+        snapshot_.Store(std::move(snapshot));
+    }
 
-            double end_position_x = curr_position_x;
-            double end_position_y = curr_position_y;
+    std::optional<SessionDelta> SessionSnapshot::DeltaSince(uint64_t since) const
+    {
+        if (since > tick || (since < tick && (history.empty() || history.front()->tick > since + 1)))
+            return std::nullopt;
+
+        // Изменения накладываются по порядку: позднее состояние собаки или трофея заменяет раннее
+        const auto key = [](const DogHandle &handle)
+        {
+            return (static_cast<uint64_t>(handle.slot) << 32) | handle.generation;
+        };
+        std::unordered_map<uint64_t, const DogSnapshot *> changed_dogs;
+        std::unordered_map<uint64_t, DogHandle> removed_dogs;
+        std::unordered_map<int, const MapLoot *> changed_loots;
+        std::unordered_set<int> removed_loots;
+
+        const auto apply = [&](const SessionDelta &delta)
+        {
+            for (const auto &handle : delta.removed_dogs)
+            {
+                changed_dogs.erase(key(handle));
+                removed_dogs.emplace(key(handle), handle);
+            }
+            for (const auto &dog : delta.changed_dogs)
+                changed_dogs[key(dog.handle)] = &dog;
 
-            auto road = dog->GetRoad();
-            if (road != nullptr)
+            for (const int id : delta.removed_loots)
             {
-                end_position_x = static_cast<double>(road->GetEnd().x);
-                end_position_y = static_cast<double>(road->GetEnd().y);
+                changed_loots.erase(id);
+                removed_loots.insert(id);
             }
+            for (const auto &loot : delta.changed_loots)
+            {
+                changed_loots[loot.id_] = &loot;
+                removed_loots.erase(loot.id_);
+            }
+        };
 
-            collision_detector::Gatherer gatherer{id_str, {curr_position_x, curr_position_y}, {end_position_x, end_position_y}, kDogWidth};
-            provider.AddGatherer(gatherer);
+        for (const auto &delta : history)
+        {
+            if (delta->tick > since)
+                apply(*delta);
         }
+        if (pending)
+            apply(*pending);
+
+        SessionDelta result;
+        result.tick = tick;
+        result.changed_dogs.reserve(changed_dogs.size());
+        for (const auto &[k, dog] : changed_dogs)
+            result.changed_dogs.push_back(*dog);
+        result.removed_dogs.reserve(removed_dogs.size());
+        for (const auto &[k, handle] : removed_dogs)
+            result.removed_dogs.push_back(handle);
+        result.changed_loots.reserve(changed_loots.size());
+        for (const auto &[id, loot] : changed_loots)
+            result.changed_loots.push_back(*loot);
+        result.removed_loots.reserve(removed_loots.size());
+        result.removed_loots.assign(removed_loots.begin(), removed_loots.end());
+        return result;
+    }
+
+    void GameSession::RemoveDogAt(size_t index)
+    {
+        const auto dog = dogs_[index];
+        const DogStore::Slot slot = dog->GetSlot();
+        dog->Detach();
 
-        for (const auto &loot : map_.GetLoots())
+        // dogs_ и dog_store_ меняют местами удаляемую и последнюю собаку одинаково
+        if (index + 1 != dogs_.size())
         {
-            collision_detector::Item item{loot.id_, {loot.position_x_, loot.position_y_}, kItemWidth};
-            provider.AddItem(item);
+            dogs_[index] = std::move(dogs_.back());
+            dog_id_to_index_[dogs_[index]->GetId()] = index;
         }
+        dogs_.pop_back();
+        dog_id_to_index_.erase(dog->GetId());
+        dog_store_.Remove(slot);
+    }
 
-        for (const auto &office : map_.GetOffices())
+    std::shared_ptr<Dog> GameSession::FindDog(const Dog::Id &id) noexcept
+    {
+        if (auto it = dog_id_to_index_.find(id); it != dog_id_to_index_.end())
         {
-            auto curr_position_x = static_cast<double>(office.GetPosition().x);
-            auto curr_position_y = static_cast<double>(office.GetPosition().y);
-            collision_detector::Item item{kOfficeID, {curr_position_x, curr_position_y}, 0.5};
-            provider.AddItem(item);
+            return dogs_.at(it->second);
         }
+        return nullptr;
+    }
 
-        auto collected_loot = collision_detector::FindGatherEvents(provider);
-        if (collected_loot.empty())
+    void GameSession::ResetProfile() noexcept
+    {
+        for (auto &histogram : profile_)
         {
+            histogram.Reset();
+        }
+    }
+
+    void GameSession::Tick(std::chrono::milliseconds time, database::RecordWriter &records)
+    {
+        {
+            util::ScopedTimer timer{ProfileOf(TickPhase::MOVEMENT)};
+            dog_store_.Move(time, *map_);
+        }
+
+        util::ScopedTimer timer{ProfileOf(TickPhase::RETIREMENT)};
+
+        retiring_.clear();
+        dog_store_.ForEachRetired([this, &records](size_t index)
+                                  {
+                                      const auto &dog_ = dogs_[index];
+                                      records.Push(database::PlayerRecord(*dog_->GetId(), dog_->GetScore(), (dog_store_.GetPlayTime(index) - dog_store_.GetAfkTime(index))));
+                                      retiring_.push_back(dog_store_.SlotAt(index)); });
+
+        for (const DogStore::Slot slot : retiring_)
+        {
+            retired_.push_back(GetHandle(*dogs_[dog_store_.IndexOf(slot)]));
+            RemoveDogAt(dog_store_.IndexOf(slot));
+        }
+    }
+
+    void GameSession::LootGenerator(add_data::GameLoots &game_loots, std::chrono::milliseconds delta)
+    {
+        const auto &all_loot = game_loots.GetLootTypes(map_->GetName());
+        const auto &roads = map_->GetRoads();
+
+        if (all_loot.empty() || roads.empty())
             return;
+
+        if (!loot_generator_)
+        {
+            const auto &prototype = game_loots.GetGenerator();
+            if (prototype == nullptr)
+                return;
+
+            loot_generator_.emplace(prototype->GetBaseInterval(), prototype->GetProbability(), [this]
+                                    { return random_.NextDouble(); });
         }
 
-        for (auto clltd_loot : collected_loot)
+        // Сколько трофеев появится, решает генератор по числу трофеев и собак; сверху - предел карты
+        const size_t live = map_state_.GetLoots().Size();
+        const size_t room = map_->GetMaxLoot() > live ? map_->GetMaxLoot() - live : 0;
+        const size_t count = std::min<size_t>(room, loot_generator_->Generate(delta, static_cast<unsigned>(live), static_cast<unsigned>(dogs_.size())));
+
+        if (count == 0)
+            return;
+
+        // Все случайные числа тика одним проходом генератора: дорога, x, y и тип для каждого трофея
+        random_draws_.resize(count * 4);
+        random_.FillDoubles(random_draws_);
+
+        for (size_t i = 0; i < count; ++i)
         {
-            CollectLoot(provider, clltd_loot.item_id, clltd_loot.gatherer_id);
-            DropLoot(provider, clltd_loot.item_id, clltd_loot.gatherer_id);
+            const double *draw = &random_draws_[i * 4];
+            const auto &road = roads[ScaleToRange(draw[0], 0, static_cast<int32_t>(roads.size()) - 1)];
+            auto x = ScaleToRange(draw[1], road.GetStart().x, road.GetEnd().x);
+            auto y = ScaleToRange(draw[2], road.GetStart().y, road.GetEnd().y);
+            auto type = ScaleToRange(draw[3], 0, static_cast<int32_t>(all_loot.size()) - 1);
+
+            map_state_.AddLoot(MapLoot(0, all_loot[type].value_, type, x, y));
+        }
+    }
+
+    collision_detector::BasicGatherer<size_t> GameSession::CollisionSource::GetGatherer(size_t idx) const noexcept
+    {
+        const auto &start = dogs_.GetStartPosition(idx);
+        const auto &end = dogs_.GetPosition(idx);
+
+        return {idx, {start.x, start.y}, {end.x, end.y}, kDogWidth};
+    }
+
+    void GameSession::FindCollision()
+    {
+        const CollisionSource source{dog_store_, *map_, map_state_};
+        collision_detector::FindGatherEvents(source, gather_events_, gather_buffers_);
+
+        for (const auto &event : gather_events_)
+        {
+            CollectLoot(event.item_id, event.gatherer_id);
+            DropLoot(event.item_id, event.gatherer_id);
         }
     };
 
-    void GameSession::CollectLoot(const collision_detector::Provider &provider, size_t item_id, std::string gatherer_id)
+    void GameSession::CollectLoot(int item_id, size_t dog_index)
     {
-        if (item_id != kOfficeID)
+        if (item_id == kOfficeID)
             return;
 
-        auto dog = FindDog(util::Tagged<std::string, Dog>(gatherer_id));
+        const auto &dog = dogs_.at(dog_index);
 
-        if (dog == nullptr)
+        if (dog->GetBagSize() >= map_->GetBagCapacity())
             return;
 
-        auto item = map_.GetLoot(item_id);
+        auto item = map_state_.GetLoot(item_id);
 
         if (item == nullptr)
             return;
 
-        dog->AddItemToBag(std::move(*item));
+        dog->AddItemToBag(MapLoot{*item});
 
-        map_.DeleteItemFromMap(item_id);
+        map_state_.DeleteItemFromMap(item_id);
     };
 
-    void GameSession::DropLoot(const collision_detector::Provider &provider, size_t item_id, std::string gatherer_id)
+    void GameSession::DropLoot(int item_id, size_t dog_index)
     {
         if (item_id != kOfficeID)
             return;
 
-        auto dog = FindDog(util::Tagged<std::string, Dog>(gatherer_id));
+        dogs_.at(dog_index)->ClearBag();
+    };
 
-        if (dog == nullptr)
-            return;
+    std::shared_ptr<const Map> Game::FindMap(const Map::Id &id) const noexcept
+    {
+        if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end())
+        {
+            return maps_.at(it->second);
+        }
+        return nullptr;
+    }
 
-        dog->ClearBag();
-    };
+    namespace
+    {
+        collision_detector::Item MakeCollisionItem(const MapLoot &loot) noexcept
+        {
+            return {loot.id_, {loot.position_x_, loot.position_y_}, kItemWidth};
+        }
+    } // namespace
 
-    const int32_t GameSession::GenerateNum(int32_t start, int32_t end)
+    int MapState::AddLoot(MapLoot new_map_loot)
     {
-        if (start == end)
-            return start;
+        const auto key = loots_.Insert(std::move(new_map_loot));
+        ++spawned_count_;
+        MapLoot &loot = *loots_.Find(key);
+        loot.id_ = static_cast<int>(key);
+
+        const auto item = MakeCollisionItem(loot);
+        try
+        {
+            loot_index_.Insert(item.position.x, item.position.y, item.position.x, item.position.y, item);
+        }
+        catch (...)
+        {
+            loots_.Erase(key);
+            throw;
+        }
 
-        if (start > end)
-            std::swap(start, end);
+        return loot.id_;
+    }
 
-        boost::random::mt19937 gen;
-        gen.seed(static_cast<unsigned int>(std::time(0)));
-        boost::random::uniform_int_distribution<> dist(start, end);
-        return dist(gen);
+    void MapState::DeleteMapLoot(const MapLoot &loot)
+    {
+        if (const MapLoot *found = GetLoot(loot.id_); found != nullptr && *found == loot)
+            DeleteItemFromMap(loot.id_);
     }
 
-    Map *Game::FindMap(const Map::Id &id) const noexcept
+    MapLoot *MapState::GetLoot(int id) noexcept
     {
-        if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end())
-        {
-            return &const_cast<Map &>(maps_.at(it->second));
-        }
-        return nullptr;
+        if (id < 0)
+            return nullptr;
+
+        return loots_.Find(static_cast<Loots::Key>(id));
     }
 
-    void Map::DeleteMapLoot(const MapLoot &loot)
+    void MapState::DeleteItemFromMap(int item_id)
     {
-        map_loot_.erase(std::find(map_loot_.begin(), map_loot_.end(), loot));
+        const MapLoot *loot = GetLoot(item_id);
+        if (loot == nullptr)
+            return;
+
+        const auto item = MakeCollisionItem(*loot);
+        loot_index_.Erase(item.position.x, item.position.y, item.position.x, item.position.y, item);
+        loots_.Erase(static_cast<Loots::Key>(item_id));
     }
 
-    MapLoot *Map::GetLoot(size_t id)
+    void Map::AddRoad(const Road &road)
     {
-        for (auto &loot : map_loot_)
+        const size_t index = roads_.size();
+        const Road &r = roads_.emplace_back(road);
+        try
         {
-            if (id == loot.id_)
-                return &loot;
+            road_index_.Insert(r.GetStart().x, r.GetStart().y, r.GetEnd().x, r.GetEnd().y, index);
+            road_graph_.AddRoad(r.GetStart().x, r.GetStart().y, r.GetEnd().x, r.GetEnd().y);
+        }
+        catch (...)
+        {
+            roads_.pop_back();
+            throw;
         }
+    }
 
-        return nullptr;
+    void Map::BuildRoadGraph()
+    {
+        road_graph_.Build();
+    }
+
+    bool Map::HasRoadAt(Point point) const noexcept
+    {
+        const auto *cell = road_index_.FindCell(point.x, point.y);
+        if (cell == nullptr)
+            return false;
+
+        return std::any_of(cell->begin(), cell->end(), [this, point](size_t index)
+                           {
+                               const Road &road = roads_[index];
+                               return IsInBounds<int>(point.x, road.GetStart().x, road.GetEnd().x) &&
+                                      IsInBounds<int>(point.y, road.GetStart().y, road.GetEnd().y); });
     }
 
-    void Map::DeleteItemFromMap(size_t item_id)
+    const Road *Map::FindRoadAt(Point point, bool horizontal) const noexcept
     {
-        for (size_t i = 0; i < map_loot_.size(); ++i)
+        const auto *cell = road_index_.FindCell(point.x, point.y);
+        if (cell == nullptr)
+            return nullptr;
+
+        for (size_t index : *cell)
         {
-            if (map_loot_.at(i).id_ == item_id)
-            {
-                map_loot_.erase(map_loot_.begin() + i);
-            }
+            const Road &road = roads_[index];
+
+            if (!IsInBounds<int>(point.x, road.GetStart().x, road.GetEnd().x) ||
+                !IsInBounds<int>(point.y, road.GetStart().y, road.GetEnd().y))
+                continue;
+
+            if (horizontal ? road.IsHorizontal() : road.IsVertical())
+                return &road;
         }
+
+        return nullptr;
     }
 
     void Map::AddOffice(const Office &office)
@@ -611,6 +1106,10 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
             offices_.pop_back();
             throw;
         }
+
+        const double x = o.GetPosition().x;
+        const double y = o.GetPosition().y;
+        office_index_.Insert(x, y, x, y, collision_detector::Item{kOfficeID, {x, y}, kOfficeWidth});
     }
 
     std::shared_ptr<GameSession> Game::FindGameSession(const GameSession::Id &id) noexcept
@@ -622,17 +1121,41 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
         return nullptr;
     }
 
-    std::shared_ptr<GameSession> Game::ConnectToSession(const std::string &map_id, const std::string &user_name)
+    std::vector<std::shared_ptr<GameSession>> Game::GetMapSessions(const Map::Id &map_id) const
+    {
+        std::vector<std::shared_ptr<GameSession>> sessions;
+
+        if (auto it = map_id_to_sessions_.find(map_id); it != map_id_to_sessions_.end())
+        {
+            sessions.reserve(it->second.size());
+            for (size_t index : it->second)
+            {
+                sessions.push_back(game_sessions_.at(index));
+            }
+        }
+
+        return sessions;
+    }
+
+    DogHandle Game::ConnectToSession(const std::string &map_id, const std::string &user_name)
     {
         std::shared_ptr<GameSession> game_session_ = nullptr;
         std::shared_ptr<Dog> dog_ = nullptr;
 
-        if (game_sessions_.size() == 0)
+        if (auto it = map_id_to_sessions_.find(util::Tagged<std::string, Map>(map_id)); it != map_id_to_sessions_.end())
         {
-            CreateNewSession(map_id);
-        }
+            for (size_t index : it->second)
+            {
+                const auto &shard = game_sessions_.at(index);
+                const size_t players = shard->GetDogs().size();
 
-        game_session_ = FindGameSession(util::Tagged<std::string, GameSession>(map_id));
+                if (max_players_per_session_ != 0 && players >= max_players_per_session_)
+                    continue;
+
+                if (game_session_ == nullptr || players < game_session_->GetDogs().size())
+                    game_session_ = shard;
+            }
+        }
 
         if (game_session_ == nullptr)
         {
@@ -641,18 +1164,34 @@ void Dog::UpdateInactionTime(std::chrono::milliseconds time)
 
         dog_ = std::make_shared<Dog>(util::Tagged<std::string, Dog>(user_name));
 
-        game_session_->AddDog(dog_, IsDefaultSpawn());
-
-        return game_session_;
+        return game_session_->AddDog(dog_, IsDefaultSpawn());
     }
 
     std::shared_ptr<GameSession> Game::CreateNewSession(const std::string &map_id)
     {
-        Map *data_map = FindMap(util::Tagged<std::string, Map>(map_id));
-        auto game_session = std::make_shared<model::GameSession>(util::Tagged<std::string, GameSession>(map_id), std::move(*data_map));
+        auto data_map = FindMap(util::Tagged<std::string, Map>(map_id));
+        if (data_map == nullptr)
+        {
+            throw std::invalid_argument("Map with id "s + map_id + " not found"s);
+        }
+
+        // Идентификатор сессии генерируется: у одной карты может быть несколько сессий
+        GameSession::Id session_id{map_id + "#"s + std::to_string(++session_counter_)};
+        while (game_session_id_to_index_.contains(session_id))
+        {
+            session_id = GameSession::Id{map_id + "#"s + std::to_string(++session_counter_)};
+        }
+
+        auto game_session = std::make_shared<model::GameSession>(std::move(session_id), std::move(data_map));
+        if (random_seed_)
+        {
+            game_session->GetRandom().Seed(MixSeed(*random_seed_, game_sessions_.size()));
+        }
+
+        auto result = game_session;
         AddGameSession(game_session);
 
-        return game_session;
+        return result;
     }
 
 } // namespace model
@@ -1,14 +1,28 @@
 #pragma once
-#include <boost/random.hpp>
 #include <boost/asio.hpp>
 
+#include <chrono>
+#include <limits>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <array>
+#include <atomic>
+#include <random>
+#include <span>
+#include <stdexcept>
 
 #include "tagged.h"
+#include "spatial_grid.h"
+#include "road_graph.h"
+#include "slot_map.h"
+#include "random_engine.h"
+#include "histogram.h"
+#include "timing_wheel.h"
+#include "atomic_snapshot.h"
 #include "loots.h"
 #include "loot_generator.h"
 #include "collision_detector.h"
@@ -25,11 +39,34 @@ namespace model
     const int32_t kItemWidth = 0.0;
     const int32_t kDogWidth = 0.6;
     const int32_t kOfficeID = -999;
+    const double kOfficeWidth = 0.5;
+    const double kRoadIndexCellSize = 16.0;
+    const double kLootIndexCellSize = 4.0;
+    const size_t kDefaultMaxLoot = 1000;
+    const std::chrono::milliseconds kDefaultMaxTickStep{50};
+    // Шаг и число корзин колеса таймеров ухода бездействующих собак
+    const int64_t kRetirementWheelResolution = 100;
+    const size_t kRetirementWheelBuckets = 1024;
+
+    // Фазы тика, время которых собирается при включённом профилировании
+    enum class TickPhase : uint8_t
+    {
+        LOOT_GENERATION,
+        MOVEMENT,
+        RETIREMENT,
+        COLLISION,
+        SAVE_STATE,
+        TICK,
+        COUNT
+    };
+
+    using TickProfile = std::array<util::LogLinearHistogram, static_cast<size_t>(TickPhase::COUNT)>;
 
     const std::string kLeftDirection = "L";
     const std::string kRightDirection = "R";
     const std::string kDownDirection = "D";
     const std::string kUpDirection = "U";
+    const std::string kNoDirection = "";
 
     struct Point
     {
@@ -50,11 +87,15 @@ namespace model
     struct Position
     {
         double x = 0, y = 0;
+
+        bool operator==(const Position &) const = default;
     };
 
     struct Speed
     {
         float x = 0, y = 0;
+
+        bool operator==(const Speed &) const = default;
     };
 
     enum class Direction
@@ -62,7 +103,8 @@ namespace model
         NORTH,
         SOUTH,
         WEST,
-        EAST
+        EAST,
+        NONE
     };
 
     struct Offset
@@ -203,6 +245,10 @@ namespace model
         Offset offset_;
     };
 
+    /*
+     *  Неизменяемая после загрузки часть карты: геометрия, базы, параметры и индексы по ним.
+     *  Одна копия на карту разделяется всеми сессиями через std::shared_ptr<const Map>.
+     */
     class Map
     {
     public:
@@ -210,7 +256,6 @@ namespace model
         using Roads = std::vector<Road>;
         using Buildings = std::vector<Building>;
         using Offices = std::vector<Office>;
-        using Loots = std::vector<MapLoot>;
 
         Map(Id id, std::string name) noexcept
             : id_(std::move(id)), name_(std::move(name))
@@ -272,33 +317,49 @@ namespace model
             return map_bag_capacity_;
         }
 
-        void AddRoad(const Road &road)
+        // Предел числа трофеев, одновременно лежащих на карте в одной сессии
+        void SetMaxLoot(size_t max_loot) noexcept
         {
-            roads_.emplace_back(road);
+            max_loot_ = max_loot;
         }
 
-        void AddBuilding(const Building &building)
+        size_t GetMaxLoot() const noexcept
         {
-            buildings_.emplace_back(building);
+            return max_loot_;
         }
 
-        void AddOffice(const Office &office);
+        void AddRoad(const Road &road);
 
-        void AddLoot(const MapLoot &new_map_loot)
+        // Есть ли на карте хотя бы одна дорога, проходящая через точку
+        bool HasRoadAt(Point point) const noexcept;
+
+        // Первая (в порядке загрузки) горизонтальная или вертикальная дорога, проходящая через точку
+        const Road *FindRoadAt(Point point, bool horizontal) const noexcept;
+
+        // Собирает граф дорог; вызывается после загрузки всех дорог, до создания сессий
+        void BuildRoadGraph();
+
+        const RoadGraph &GetRoadGraph() const noexcept
         {
-            map_loot_.push_back(new_map_loot);
+            return road_graph_;
         }
 
-        std::vector<MapLoot> GetLoots() const
+        void AddBuilding(const Building &building)
         {
-            return map_loot_;
+            buildings_.emplace_back(building);
         }
 
-        void DeleteMapLoot(const MapLoot &loot);
-
-        MapLoot *GetLoot(size_t id);
+        void AddOffice(const Office &office);
 
-        void DeleteItemFromMap(size_t item_id);
+        // Вызывает fn(const collision_detector::Item &) для баз из ячеек, пересекающих прямоугольник
+        template <typename Fn>
+        void ForEachOfficeItem(double min_x, double min_y, double max_x, double max_y, Fn &&fn) const
+        {
+            office_index_.ForEachCell(min_x, min_y, max_x, max_y, [&fn](const auto &cell)
+                                      {
+                                          for (const auto &item : cell)
+                                              fn(item); });
+        }
 
     private:
         using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
@@ -306,8 +367,10 @@ namespace model
         Id id_;
         std::string name_;
         Roads roads_;
+        util::SpatialGrid<size_t> road_index_{kRoadIndexCellSize};
+        RoadGraph road_graph_;
         Buildings buildings_;
-        Loots map_loot_;
+        util::SpatialGrid<collision_detector::Item> office_index_{kLootIndexCellSize};
 
         OfficeIdToIndex warehouse_id_to_index_;
         Offices offices_;
@@ -315,15 +378,257 @@ namespace model
         size_t map_dog_speed_ = 0;
         size_t map_bag_capacity_ = 0;
         size_t retirement_time_ = 0;
+        size_t max_loot_ = kDefaultMaxLoot;
+    };
+
+    // Изменяемое состояние карты в одной игровой сессии: трофеи на земле и их индекс
+    class MapState
+    {
+    public:
+        // Идентификатор трофея на карте - ключ в Loots
+        using Loots = util::SlotMap<MapLoot>;
+
+        // Добавляет трофей на карту, присваивает ему новый идентификатор и возвращает его
+        int AddLoot(MapLoot new_map_loot);
+
+        const Loots &GetLoots() const noexcept
+        {
+            return loots_;
+        }
+
+        void DeleteMapLoot(const MapLoot &loot);
+
+        MapLoot *GetLoot(int id) noexcept;
+
+        void DeleteItemFromMap(int item_id);
+
+        // Сколько трофеев было создано в сессии за всё время
+        size_t GetSpawnedCount() const noexcept
+        {
+            return spawned_count_;
+        }
+
+        void SetSpawnedCount(size_t count) noexcept
+        {
+            spawned_count_ = count;
+        }
+
+        // Резервирует место под count трофеев, чтобы появление новых не выделяло память
+        void Reserve(size_t count)
+        {
+            loots_.Reserve(count);
+        }
+
+        // Вызывает fn(const collision_detector::Item &) для трофеев из ячеек, пересекающих прямоугольник
+        template <typename Fn>
+        void ForEachLootItem(double min_x, double min_y, double max_x, double max_y, Fn &&fn) const
+        {
+            loot_index_.ForEachCell(min_x, min_y, max_x, max_y, [&fn](const auto &cell)
+                                    {
+                                        for (const auto &item : cell)
+                                            fn(item); });
+        }
+
+    private:
+        Loots loots_;
+
+        // Индекс обновляется при появлении и подборе трофеев, а не перестраивается каждый тик
+        util::SpatialGrid<collision_detector::Item> loot_index_{kLootIndexCellSize};
+
+        size_t spawned_count_ = 0;
     };
 
+    /*
+     *  "Горячие" данные собак игровой сессии в виде структуры массивов.
+     *  Собака адресуется стабильным слотом, таблица слотов переводит его в плотный индекс,
+     *  поэтому тик проходит по непрерывным массивам, не трогая объекты Dog.
+     */
+    class DogStore
+    {
+    public:
+        using Slot = uint32_t;
+        static constexpr uint32_t kNoSegment = RoadGraph::kNone;
+
+        struct State
+        {
+            Position position;
+            Speed speed;
+            Direction direction = Direction::NORTH;
+            uint32_t segment = kNoSegment;
+            int64_t afk_time = 0;
+            int64_t play_time = 0;
+            bool inaction = false;
+        };
+
+        Slot Add(const State &state);
+
+        // Удаляет собаку: последняя собака переезжает на её плотный индекс, поколение слота меняется
+        void Remove(Slot slot);
+
+        // Текущее состояние собаки для переноса обратно в Dog
+        State GetState(size_t index) const noexcept;
+
+        size_t Size() const noexcept
+        {
+            return positions_.size();
+        }
+
+        size_t IndexOf(Slot slot) const noexcept
+        {
+            return slot_to_index_[slot];
+        }
+
+        Slot SlotAt(size_t index) const noexcept
+        {
+            return index_to_slot_[index];
+        }
+
+        // Поколение слота меняется, когда слот освобождается, и отличает старые ссылки на него
+        uint32_t GetGeneration(Slot slot) const noexcept
+        {
+            return slot_generations_[slot];
+        }
+
+        bool Contains(Slot slot, uint32_t generation) const noexcept
+        {
+            return slot < slot_to_index_.size() && slot_to_index_[slot] != kFreeSlot && slot_generations_[slot] == generation;
+        }
+
+        // Перемещает всех собак за время time, обрезает движение по дорогам карты и продвигает часы хранилища
+        void Move(std::chrono::milliseconds time, const Map &map);
+
+        // Время хранилища в миллисекундах: сумма всех тиков
+        int64_t GetNow() const noexcept
+        {
+            return now_;
+        }
+
+        // Бездействие дольше retirement_time миллисекунд выводит собаку из игры
+        void SetRetirementTime(int64_t retirement_time) noexcept
+        {
+            retirement_time_ = retirement_time;
+        }
+
+        /*
+         *  Вызывает fn(index) для собак, бездействующих дольше времени ухода.
+         *  Срок ухода ставится в колесо таймеров, когда собака останавливается, поэтому
+         *  за тик проверяются только сработавшие таймеры, а не все собаки. Собаки остаются в хранилище.
+         */
+        template <typename Fn>
+        void ForEachRetired(Fn &&fn)
+        {
+            idle_timers_.Advance(now_, [this, &fn](IdleTimer timer)
+                                 {
+                                     if (!Contains(timer.slot, timer.generation) || idle_epochs_[timer.slot] != timer.epoch)
+                                         return;
+
+                                     const size_t index = IndexOf(timer.slot);
+                                     if (IsAfk(index) && GetAfkTime(index) > retirement_time_)
+                                         fn(index); });
+        }
+
+        bool IsAfk(size_t index) const noexcept
+        {
+            return speeds_[index].x == 0 && speeds_[index].y == 0 && inaction_[index];
+        }
+
+        const Position &GetPosition(size_t index) const noexcept { return positions_[index]; }
+        // Положение собаки до последнего вызова Move
+        const Position &GetStartPosition(size_t index) const noexcept { return start_positions_[index]; }
+        const Speed &GetSpeed(size_t index) const noexcept { return speeds_[index]; }
+        Direction GetDirection(size_t index) const noexcept { return directions_[index]; }
+        uint32_t GetSegment(size_t index) const noexcept { return segments_[index]; }
+        int64_t GetAfkTime(size_t index) const noexcept { return inaction_[index] ? now_ - idle_since_[index] : 0; }
+        int64_t GetPlayTime(size_t index) const noexcept { return now_ - joined_at_[index]; }
+        bool GetInaction(size_t index) const noexcept { return inaction_[index]; }
+
+        void SetPosition(size_t index, Position position) noexcept { positions_[index] = position; }
+        void SetSpeed(size_t index, Speed speed) noexcept { speeds_[index] = speed; }
+        void SetDirection(size_t index, Direction direction) noexcept { directions_[index] = direction; }
+        void SetSegment(size_t index, uint32_t segment) noexcept { segments_[index] = segment; }
+        void SetPlayTime(size_t index, int64_t play_time) noexcept { joined_at_[index] = now_ - play_time; }
+        void SetInaction(size_t index, bool value);
+
+    private:
+        static constexpr size_t kFreeSlot = std::numeric_limits<size_t>::max();
+
+        struct IdleTimer
+        {
+            Slot slot;
+            uint32_t generation;
+            // Номер остановки собаки: таймер прежней остановки устаревает, когда собака снова двинулась
+            uint32_t epoch;
+        };
+
+        void Stop(size_t index) noexcept
+        {
+            speeds_[index] = {0, 0};
+        }
+
+        void StartIdle(size_t index, int64_t idle_since);
+
+        // Двигает собаку по отрезку графа дорог, поворачивая только на перекрёстках
+        void MoveAlongRoad(size_t index, const RoadGraph &graph, const Map &map, double x, double y);
+
+        // Отрезок графа под собакой, если он ещё не известен
+        uint32_t LocateSegment(size_t index, const Map &map) const noexcept;
+
+        std::vector<Position> positions_;
+        std::vector<Position> start_positions_;
+        std::vector<Speed> speeds_;
+        std::vector<Direction> directions_;
+        std::vector<uint32_t> segments_;
+        // Моменты начала бездействия и входа в игру по часам хранилища
+        std::vector<int64_t> idle_since_;
+        std::vector<int64_t> joined_at_;
+        std::vector<uint8_t> inaction_;
+
+        // Координаты после интегрирования, переиспользуются между тиками
+        std::vector<double> next_x_;
+        std::vector<double> next_y_;
+
+        std::vector<size_t> slot_to_index_;
+        std::vector<Slot> index_to_slot_;
+        std::vector<uint32_t> slot_generations_;
+        std::vector<uint32_t> idle_epochs_;
+        std::vector<Slot> free_slots_;
+
+        int64_t now_ = 0;
+        int64_t retirement_time_ = std::numeric_limits<int64_t>::max() / 2;
+        util::TimingWheel<IdleTimer> idle_timers_{kRetirementWheelResolution, kRetirementWheelBuckets};
+    };
+
+    /*
+     *  Компактная ссылка на собаку: индекс сессии в Game, слот в DogStore сессии и поколение слота.
+     *  Используется на горячих путях вместо строковых идентификаторов собаки и сессии.
+     */
+    struct DogHandle
+    {
+        static constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
+
+        uint32_t session = kInvalid;
+        DogStore::Slot slot = kInvalid;
+        uint32_t generation = 0;
+
+        bool IsValid() const noexcept
+        {
+            return session != kInvalid;
+        }
+
+        bool operator==(const DogHandle &) const = default;
+    };
+
+    /*
+     *  Собака игрока. Имя, рюкзак и очки хранятся в объекте,
+     *  а положение, скорость и таймеры после добавления в сессию живут в DogStore.
+     */
     class Dog
     {
     public:
         using Id = util::Tagged<std::string, Dog>;
 
         Dog(Id id) noexcept
-            : id_(std::move(id)), direction_{"U"}
+            : id_(std::move(id))
         {
         }
 
@@ -334,22 +639,21 @@ namespace model
 
         const Position &GetPosition() const noexcept
         {
-            return position_;
+            return store_ ? store_->GetPosition(Index()) : state_.position;
         }
 
         const Speed &GetSpeed() const noexcept
         {
-            return speed_;
+            return store_ ? store_->GetSpeed(Index()) : state_.speed;
         }
 
-        const std::string &GetDirection() const noexcept
+        Direction GetDirectionType() const noexcept
         {
-            return direction_;
+            return store_ ? store_->GetDirection(Index()) : state_.direction;
         }
 
-        void Tick(std::chrono::milliseconds time, const model::Map &map);
-        void UpdateHorizontal(const Road &&road, const double &x);
-        void UpdateVertical(const Road &&road, const double &y);
+        const std::string &GetDirection() const noexcept;
+
         void SetDirection(const std::string &direction, size_t current_speed_);
         void SetPosition(const double &x, const double &y);
 
@@ -363,49 +667,109 @@ namespace model
 
         std::vector<MapLoot> GetBag() const noexcept;
 
-        std::shared_ptr<Road> GetRoad() const noexcept;
+        size_t GetBagSize() const noexcept
+        {
+            return bag_.size();
+        }
+
+        // Отрезок графа дорог карты, по которому идёт собака, или DogStore::kNoSegment
+        uint32_t GetRoadSegment() const noexcept
+        {
+            return store_ ? store_->GetSegment(Index()) : state_.segment;
+        }
 
-        void UpdateRoad(const Road &road);
+        void SetRoadSegment(uint32_t segment) noexcept;
 
         bool isAfk() const noexcept
         {
-            return (speed_.x == 0 && speed_.y == 0 && inaction_);
+            return store_ ? store_->IsAfk(Index()) : (state_.speed.x == 0 && state_.speed.y == 0 && state_.inaction);
         }
 
         int64_t GetRetirementTime() const noexcept
         {
-            return afk_time_;
+            return store_ ? store_->GetAfkTime(Index()) : state_.afk_time;
         }
 
-        void SetPlayTime(int64_t play_time)
-        {
-            play_time_ = play_time;
-        }
+        void SetPlayTime(int64_t play_time);
 
         int64_t GetPlayTime() const noexcept
         {
-            return play_time_;
+            return store_ ? store_->GetPlayTime(Index()) : state_.play_time;
         }
 
-        void UpdateInactionTime(std::chrono::milliseconds time);
-
         void SetInaction(bool value);
 
+        // Переносит состояние собаки в хранилище сессии
+        void Attach(DogStore &store);
+
+        // Забирает состояние собаки из хранилища перед её удалением из сессии
+        void Detach() noexcept;
+
+        DogStore::Slot GetSlot() const noexcept
+        {
+            return slot_;
+        }
+
     private:
-        Id id_;
-        Speed speed_;
-        Position position_;
-        std::shared_ptr<Road> current_road_ = nullptr;
-        std::string direction_;
+        size_t Index() const noexcept
+        {
+            return store_->IndexOf(slot_);
+        }
 
         void SetSpeed(const int32_t &x, const int32_t &y);
 
+        Id id_;
+        DogStore *store_ = nullptr;
+        DogStore::Slot slot_ = 0;
+        DogStore::State state_;
+
         std::vector<MapLoot> bag_;
         size_t score_{0};
-        int64_t afk_time_{0};
-        int64_t play_time_{0};
+    };
 
-        bool inaction_ = false;
+    struct DogSnapshot
+    {
+        DogHandle handle;
+        std::string name;
+        Position position;
+        Speed speed;
+        std::string direction;
+        std::vector<MapLoot> bag;
+        size_t score = 0;
+
+        bool operator==(const DogSnapshot &) const = default;
+    };
+
+    // Сколько последних тиков хранит снимок для ответов ?since=
+    constexpr size_t kStateHistoryWindow = 64;
+
+    // Изменения от конца тика tick - 1 к концу тика tick: новые и изменившиеся собаки и трофеи передаются целиком
+    struct SessionDelta
+    {
+        uint64_t tick = 0;
+        std::vector<DogSnapshot> changed_dogs;
+        std::vector<DogHandle> removed_dogs;
+        std::vector<MapLoot> changed_loots;
+        std::vector<int> removed_loots;
+    };
+
+    /*
+     *  Состояние сессии после тика tick; публикуется целиком и после публикации не меняется.
+     *  Вход и выход собак между тиками публикуются с тем же номером тика: их изменения лежат в pending
+     *  и войдут в дельту следующего тика, поэтому номер тика остаётся курсором ?since= без пропусков.
+     */
+    struct SessionSnapshot
+    {
+        uint64_t tick = 0;
+        std::vector<DogSnapshot> dogs;
+        std::vector<MapLoot> loots;
+        // Дельты последних тиков, от старых к новым; последняя ведёт к tick
+        std::vector<std::shared_ptr<const SessionDelta>> history;
+        // Изменения после конца тика tick (вход и выход собак) или nullptr
+        std::shared_ptr<const SessionDelta> pending;
+
+        // Сводка изменений после тика since; nullopt, если since вне окна истории
+        std::optional<SessionDelta> DeltaSince(uint64_t since) const;
     };
 
     class GameSession
@@ -415,11 +779,19 @@ namespace model
         using DogId = util::Tagged<std::string, Dog>;
         using Dogs = std::vector<std::shared_ptr<Dog>>;
 
-        GameSession(Id id, const Map &&map) noexcept
+        GameSession(Id id, std::shared_ptr<const Map> map)
             : id_{std::move(id)}, map_{std::move(map)}
         {
+            if (!map_->GetRoadGraph().IsBuilt())
+                throw std::invalid_argument("Road graph of map "s + *map_->GetId() + " is not built"s);
+            map_state_.Reserve(map_->GetMaxLoot());
+            dog_store_.SetRetirementTime(static_cast<int64_t>(map_->GetRetirementTime()));
         }
 
+        // Собаки ссылаются на хранилище сессии, поэтому сессия живёт только в shared_ptr
+        GameSession(const GameSession &) = delete;
+        GameSession &operator=(const GameSession &) = delete;
+
         const Id &GetId() const noexcept
         {
             return id_;
@@ -431,62 +803,205 @@ namespace model
         }
 
         const Map &GetMap() const noexcept
+        {
+            return *map_;
+        }
+
+        const std::shared_ptr<const Map> &GetSharedMap() const noexcept
         {
             return map_;
         }
 
-        void SetMap(Map &&map)
+        MapState &GetMapState() noexcept
+        {
+            return map_state_;
+        }
+
+        const MapState &GetMapState() const noexcept
         {
-            map_ = std::move(map);
+            return map_state_;
         }
 
-        void AddDog(std::shared_ptr<Dog> &dog, const bool default_spawn);
+        DogHandle AddDog(std::shared_ptr<Dog> &dog, const bool default_spawn);
 
-        void AddDog(std::shared_ptr<Dog> &dog);
+        DogHandle AddDog(std::shared_ptr<Dog> &dog);
 
-        void DeleteDog(const Dog::Id &id)
+        // Удаляет собаку из сессии за O(1): на её место переезжает последняя собака
+        void DeleteDog(const Dog::Id &id);
+
+        // Ссылки на собак, ушедших из игры в прошедших тиках; список очищается
+        std::vector<DogHandle> TakeRetired()
         {
-            return;
+            return std::exchange(retired_, {});
         }
 
         size_t GetMaxNumLoot() const noexcept
         {
-            return num_loot_;
+            return map_state_.GetSpawnedCount();
         }
 
         void SetMaxNumLoot(size_t num)
         {
-            num_loot_ = num;
+            map_state_.SetSpawnedCount(num);
         }
 
         std::shared_ptr<Dog> FindDog(const Dog::Id &id) noexcept;
 
-        void Tick(std::chrono::milliseconds time, database::PlayerRecordRepository& player_rep_);
+        // Собака по ссылке или nullptr, если ссылка устарела или относится к другой сессии
+        Dog *FindDog(DogHandle handle) const noexcept
+        {
+            if (handle.session != index_ || !dog_store_.Contains(handle.slot, handle.generation))
+                return nullptr;
+
+            return dogs_[dog_store_.IndexOf(handle.slot)].get();
+        }
+
+        DogHandle GetHandle(const Dog &dog) const noexcept
+        {
+            return {index_, dog.GetSlot(), dog_store_.GetGeneration(dog.GetSlot())};
+        }
+
+        // Генератор случайных чисел сессии: появление собак и трофеев
+        util::RandomEngine &GetRandom() noexcept
+        {
+            return random_;
+        }
+
+        const util::RandomEngine &GetRandom() const noexcept
+        {
+            return random_;
+        }
+
+        // Индекс сессии в Game, назначается при добавлении сессии в игру
+        uint32_t GetIndex() const noexcept
+        {
+            return index_;
+        }
+
+        void SetIndex(uint32_t index) noexcept
+        {
+            index_ = index;
+        }
+
+        // Профиль фаз тика сессии; записывается, только пока профилирование включено
+        void SetProfiling(bool enabled) noexcept
+        {
+            profiling_.store(enabled, std::memory_order_relaxed);
+        }
+
+        const TickProfile &GetProfile() const noexcept
+        {
+            return profile_;
+        }
+
+        // Гистограмма фазы или nullptr, если профилирование выключено
+        util::LogLinearHistogram *ProfileOf(TickPhase phase) noexcept
+        {
+            return profiling_.load(std::memory_order_relaxed) ? &profile_[static_cast<size_t>(phase)] : nullptr;
+        }
+
+        void ResetProfile() noexcept;
+
+        // Последний опубликованный снимок; читается с любого потока без блокировок
+        std::shared_ptr<const SessionSnapshot> GetSnapshot() const noexcept
+        {
+            return snapshot_.Load();
+        }
+
+        // Завершает тик: номер тика растёт, изменения за тик дописываются в историю. O(собак + трофеев)
+        void PublishTick();
+        // Публикует вход или уход собаки между тиками под номером последнего тика.
+        // Действия игроков не публикуются и становятся видны в снимке следующего тика
+        void PublishSnapshot();
+
+        // Рекорды ушедших собак передаются в очередь отложенной записи
+        void Tick(std::chrono::milliseconds time, database::RecordWriter &records);
         void LootGenerator(add_data::GameLoots &game_loots, std::chrono::milliseconds delta);
         void FindCollision();
-        void CollectLoot(const collision_detector::Provider &provider, size_t item_id, std::string gatherer_id);
-        void DropLoot(const collision_detector::Provider &provider, size_t item_id, std::string gatherer_id);
+        void CollectLoot(int item_id, size_t dog_index);
+        void DropLoot(int item_id, size_t dog_index);
 
     private:
+        /*
+         *  Собаки сессии и индекс предметов карты для collision_detector.
+         *  Собиратель - путь собаки за последний тик, предметы берутся только из ячеек вокруг этого пути.
+         */
+        class CollisionSource
+        {
+        public:
+            CollisionSource(const DogStore &dogs, const Map &map, const MapState &map_state) noexcept
+                : dogs_{dogs}, map_{map}, map_state_{map_state}
+            {
+            }
+
+            size_t GatherersCount() const noexcept
+            {
+                return dogs_.Size();
+            }
+
+            // Идентификатор собирателя - плотный индекс собаки в сессии
+            collision_detector::BasicGatherer<size_t> GetGatherer(size_t idx) const noexcept;
+
+            double MaxItemWidth() const noexcept
+            {
+                return std::max<double>(kItemWidth, kOfficeWidth);
+            }
+
+            template <typename Fn>
+            void ForEachItemNear(double min_x, double min_y, double max_x, double max_y, Fn &&fn) const
+            {
+                map_state_.ForEachLootItem(min_x, min_y, max_x, max_y, fn);
+                map_.ForEachOfficeItem(min_x, min_y, max_x, max_y, fn);
+            }
+
+        private:
+            const DogStore &dogs_;
+            const Map &map_;
+            const MapState &map_state_;
+        };
+
         using DogIdHasher = util::TaggedHasher<Dog::Id>;
         using DogIdToIndex = std::unordered_map<Dog::Id, size_t, DogIdHasher>;
 
+        // dogs_[i] соответствует плотному индексу i в dog_store_
         std::vector<std::shared_ptr<Dog>> dogs_;
+        DogStore dog_store_;
         DogIdToIndex dog_id_to_index_;
 
+        std::vector<collision_detector::BasicGatheringEvent<size_t>> gather_events_;
+        collision_detector::GatherBuffers gather_buffers_;
+
         const Id id_;
-        Map map_;
+        uint32_t index_ = DogHandle::kInvalid;
+        std::shared_ptr<const Map> map_;
+        MapState map_state_;
 
-        const int32_t GenerateNum(int32_t start, int32_t end);
-        void SetPositionDog(std::shared_ptr<Dog> &dog, const bool default_spawn);
+        util::RandomEngine random_{std::random_device{}()};
+        std::vector<double> random_draws_;
+
+        // Создаётся при первом тике из настроек lootGeneratorConfig и берёт случайные числа из random_
+        std::optional<loot_gen::LootGenerator> loot_generator_;
+
+        std::atomic<bool> profiling_{false};
+        TickProfile profile_;
+
+        // Собаки, ушедшие в этом тике, и их ссылки до удаления
+        std::vector<DogStore::Slot> retiring_;
+        std::vector<DogHandle> retired_;
 
-        size_t num_loot_ = 0;
+        util::AtomicSnapshot<SessionSnapshot> snapshot_{std::make_shared<const SessionSnapshot>()};
+        // Снимок на конец последнего тика: от него считаются дельты следующего тика и pending
+        std::shared_ptr<const SessionSnapshot> tick_snapshot_ = snapshot_.Load();
+
+        void SetPositionDog(std::shared_ptr<Dog> &dog, const bool default_spawn);
+        void RemoveDogAt(size_t index);
+        std::shared_ptr<SessionSnapshot> MakeSnapshot() const;
     };
 
     class Game
     {
     public:
-        using Maps = std::vector<Map>;
+        using Maps = std::vector<std::shared_ptr<const Map>>;
         using Session = std::vector<std::shared_ptr<GameSession>>;
 
         Game(bool is_debug, bool default_spawn) : is_debug_(is_debug), default_spawn_(default_spawn)
@@ -501,15 +1016,103 @@ namespace model
         void AddMap(Map &&map);
         void AddGameSession(std::shared_ptr<GameSession> &game_session_);
 
-        Map *FindMap(const Map::Id &id) const noexcept;
+        std::shared_ptr<const Map> FindMap(const Map::Id &id) const noexcept;
 
+        // Сессии не разделяют изменяемых данных, поэтому при threads > 1 тик сессий идёт параллельно
+        void SetTickThreads(unsigned threads);
+
+        unsigned GetTickThreads() const noexcept
+        {
+            return tick_threads_;
+        }
+
+        // Промежуток длиннее максимального шага считается несколькими шагами
         void Tick(std::chrono::milliseconds time, add_data::GameLoots &game_loots);
+        // Рекорды ушедших собак уходят в records, а не в очередь подключённой базы
+        void Tick(std::chrono::milliseconds time, add_data::GameLoots &game_loots, database::RecordWriter &records);
+
+        // Ссылки на собак, ушедших из игры во всех сессиях с прошлого вызова
+        std::vector<DogHandle> TakeRetiredDogs();
+
+        // Максимальная длительность одного шага симуляции, 0 - без дробления
+        void SetMaxTickStep(std::chrono::milliseconds step) noexcept
+        {
+            max_tick_step_ = step;
+        }
+
+        std::chrono::milliseconds GetMaxTickStep() const noexcept
+        {
+            return max_tick_step_;
+        }
+
+        // Включает профилирование фаз тика в игре и во всех её сессиях
+        void SetProfiling(bool enabled) noexcept;
+
+        bool IsProfiling() const noexcept
+        {
+            return profiling_;
+        }
+
+        // Профиль фаз уровня игры: весь тик и сохранение состояния
+        const TickProfile &GetProfile() const noexcept
+        {
+            return *profile_;
+        }
+
+        util::LogLinearHistogram *ProfileOf(TickPhase phase) noexcept
+        {
+            return profiling_ ? &(*profile_)[static_cast<size_t>(phase)] : nullptr;
+        }
+
+        void ResetProfile() noexcept;
+
         void DisconnectSession(GameSession *game_session_, Dog *dog_);
 
         std::shared_ptr<GameSession> FindGameSession(const GameSession::Id &id) noexcept;
-        std::shared_ptr<GameSession> ConnectToSession(const std::string &map_id, const std::string &user_name);
+
+        // Сессия по индексу (GameSession::GetIndex) или nullptr
+        GameSession *GetGameSession(uint32_t index) const noexcept
+        {
+            return index < game_sessions_.size() ? game_sessions_[index].get() : nullptr;
+        }
+
+        Dog *FindDog(DogHandle handle) const noexcept
+        {
+            const GameSession *session = GetGameSession(handle.session);
+            return session == nullptr ? nullptr : session->FindDog(handle);
+        }
+
+        // Снимок сессии по индексу без блокировок: список сессий тоже публикуется снимком
+        std::shared_ptr<const SessionSnapshot> GetSessionSnapshot(uint32_t index) const noexcept
+        {
+            const auto sessions = published_sessions_.Load();
+            return sessions && index < sessions->size() ? (*sessions)[index]->GetSnapshot() : nullptr;
+        }
+
+        // Добавляет собаку в наименее загруженную сессию карты (при заполнении всех создаёт новую) и возвращает ссылку на неё
+        DogHandle ConnectToSession(const std::string &map_id, const std::string &user_name);
         std::shared_ptr<GameSession> CreateNewSession(const std::string &map_id);
 
+        // Максимальное число игроков в одной сессии карты, 0 - без ограничения
+        void SetMaxPlayersPerSession(size_t max_players) noexcept
+        {
+            max_players_per_session_ = max_players;
+        }
+
+        size_t GetMaxPlayersPerSession() const noexcept
+        {
+            return max_players_per_session_;
+        }
+
+        // Зерно для генераторов новых сессий; без него сессии засеваются из std::random_device
+        void SetRandomSeed(std::optional<uint64_t> seed) noexcept
+        {
+            random_seed_ = seed;
+        }
+
+        // Сессии (шарды), созданные для карты
+        std::vector<std::shared_ptr<GameSession>> GetMapSessions(const Map::Id &map_id) const;
+
         const Maps &GetMaps() const noexcept
         {
             return maps_;
@@ -541,6 +1144,8 @@ namespace model
         }
 
     private:
+        void TickStep(std::chrono::milliseconds time, add_data::GameLoots &game_loots, database::RecordWriter &records);
+
         using MapIdHasher = util::TaggedHasher<Map::Id>;
         using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
 
@@ -551,11 +1156,27 @@ namespace model
         MapIdToIndex map_id_to_index_;
 
         Session game_sessions_;
+        // Копия game_sessions_ для чтения с любых потоков; заменяется при добавлении сессии
+        util::AtomicSnapshot<std::vector<std::shared_ptr<const GameSession>>> published_sessions_;
         GameSessionIdToIndex game_session_id_to_index_;
 
+        // Индексы сессий в game_sessions_ для каждой карты
+        std::unordered_map<Map::Id, std::vector<size_t>, MapIdHasher> map_id_to_sessions_;
+        size_t max_players_per_session_ = 0;
+        size_t session_counter_ = 0;
+        std::optional<uint64_t> random_seed_;
+
         const bool is_debug_;
         const bool default_spawn_;
 
+        unsigned tick_threads_ = 1;
+        std::shared_ptr<boost::asio::thread_pool> tick_pool_ = nullptr;
+        std::chrono::milliseconds max_tick_step_ = kDefaultMaxTickStep;
+
+        bool profiling_ = false;
+        // Общий для копий игры, гистограммы не копируются
+        std::shared_ptr<TickProfile> profile_ = std::make_shared<TickProfile>();
+
         std::shared_ptr<database::Database> db_ = nullptr;
     };
 
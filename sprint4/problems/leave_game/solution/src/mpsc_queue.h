@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace util
+{
+    /*
+     *  Ограниченная очередь без блокировок: много писателей, один читатель (схема Вьюкова).
+     *  У каждой ячейки есть номер последовательности, по которому писатель узнаёт, что ячейка свободна,
+     *  а читатель - что она заполнена. Ёмкость округляется вверх до степени двойки.
+     */
+    template <typename T>
+    class MpscQueue
+    {
+    public:
+        explicit MpscQueue(size_t capacity)
+            : mask_{RoundUpToPowerOfTwo(capacity) - 1}, cells_{std::make_unique<Cell[]>(mask_ + 1)}
+        {
+            for (size_t i = 0; i <= mask_; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscQueue(const MpscQueue &) = delete;
+        MpscQueue &operator=(const MpscQueue &) = delete;
+
+        size_t Capacity() const noexcept
+        {
+            return mask_ + 1;
+        }
+
+        // Приблизительный размер: точен, только пока писатели и читатель стоят
+        size_t Size() const noexcept
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t head = head_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        // Возвращает false, если очередь заполнена
+        bool TryPush(T value)
+        {
+            size_t position = tail_.load(std::memory_order_relaxed);
+            Cell *cell = nullptr;
+
+            for (;;)
+            {
+                cell = &cells_[position & mask_];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                if (diff == 0)
+                {
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = tail_.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->value.emplace(std::move(value));
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Вызывается только из одного потока-читателя
+        std::optional<T> TryPop()
+        {
+            const size_t position = head_.load(std::memory_order_relaxed);
+            Cell &cell = cells_[position & mask_];
+
+            if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+                return std::nullopt;
+
+            std::optional<T> result{std::move(cell.value)};
+            cell.value.reset();
+            head_.store(position + 1, std::memory_order_relaxed);
+            cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+            return result;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence{0};
+            std::optional<T> value;
+        };
+
+        static size_t RoundUpToPowerOfTwo(size_t value) noexcept
+        {
+            size_t result = 1;
+            while (result < value)
+                result <<= 1;
+            return result;
+        }
+
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+
+        // Писатели и читатель работают с разными концами, разносим их по строкам кеша
+        alignas(64) std::atomic<size_t> tail_{0};
+        alignas(64) std::atomic<size_t> head_{0};
+    };
+
+} // namespace util
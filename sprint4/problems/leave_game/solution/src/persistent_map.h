@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+    /*
+     *  Неизменяемая хеш-таблица с общими узлами: префиксное дерево по kBits бит хеша.
+     *  Insert и Erase возвращают новую версию и копируют только путь от корня до изменённого листа,
+     *  поэтому изменение стоит O(log n), а прежние версии остаются действительными для читателей.
+     */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class PersistentHashMap
+    {
+    public:
+        std::size_t Size() const noexcept
+        {
+            return size_;
+        }
+
+        bool Empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        const Value *Find(const Key &key) const
+        {
+            const std::size_t hash = Hash{}(key);
+            const Node *node = root_.get();
+
+            for (unsigned depth = 0; node != nullptr; ++depth)
+            {
+                if (node->children.empty())
+                {
+                    for (const auto &entry : node->entries)
+                    {
+                        if (entry.first == key)
+                            return &entry.second;
+                    }
+                    return nullptr;
+                }
+                node = node->children[ChunkOf(hash, depth)].get();
+            }
+            return nullptr;
+        }
+
+        // Новая версия с парой key -> value (значение существующего ключа заменяется)
+        [[nodiscard]] PersistentHashMap Insert(Key key, Value value) const
+        {
+            bool added = false;
+            PersistentHashMap result;
+            result.root_ = Insert(root_, Hash{}(key), 0, std::move(key), std::move(value), added);
+            result.size_ = size_ + (added ? 1 : 0);
+            return result;
+        }
+
+        [[nodiscard]] PersistentHashMap Erase(const Key &key) const
+        {
+            bool removed = false;
+            PersistentHashMap result;
+            result.root_ = Erase(root_, Hash{}(key), 0, key, removed);
+            result.size_ = size_ - (removed ? 1 : 0);
+            return result;
+        }
+
+    private:
+        static constexpr unsigned kBits = 5;
+        static constexpr std::size_t kWidth = std::size_t{1} << kBits;
+        // Лист делится, когда в нём больше kMaxBucket ключей; на последнем уровне хеш исчерпан
+        static constexpr std::size_t kMaxBucket = 8;
+        static constexpr unsigned kMaxDepth = (sizeof(std::size_t) * 8 + kBits - 1) / kBits;
+
+        // Лист хранит пары, внутренний узел - kWidth потомков
+        struct Node
+        {
+            std::vector<std::pair<Key, Value>> entries;
+            std::vector<std::shared_ptr<const Node>> children;
+        };
+
+        using NodePtr = std::shared_ptr<const Node>;
+
+        static std::size_t ChunkOf(std::size_t hash, unsigned depth) noexcept
+        {
+            const unsigned shift = depth * kBits;
+            return shift < sizeof(std::size_t) * 8 ? (hash >> shift) & (kWidth - 1) : 0;
+        }
+
+        static NodePtr Insert(const NodePtr &node, std::size_t hash, unsigned depth, Key key, Value value, bool &added)
+        {
+            if (node == nullptr)
+            {
+                auto leaf = std::make_shared<Node>();
+                leaf->entries.emplace_back(std::move(key), std::move(value));
+                added = true;
+                return leaf;
+            }
+
+            if (!node->children.empty())
+            {
+                auto copy = std::make_shared<Node>(*node);
+                auto &child = copy->children[ChunkOf(hash, depth)];
+                child = Insert(child, hash, depth + 1, std::move(key), std::move(value), added);
+                return copy;
+            }
+
+            auto leaf = std::make_shared<Node>(*node);
+            for (auto &entry : leaf->entries)
+            {
+                if (entry.first == key)
+                {
+                    entry.second = std::move(value);
+                    return leaf;
+                }
+            }
+
+            leaf->entries.emplace_back(std::move(key), std::move(value));
+            added = true;
+            if (leaf->entries.size() <= kMaxBucket || depth + 1 >= kMaxDepth)
+                return leaf;
+
+            // Переполненный лист становится внутренним узлом
+            auto inner = std::make_shared<Node>();
+            inner->children.resize(kWidth);
+            for (auto &entry : leaf->entries)
+            {
+                const std::size_t entry_hash = Hash{}(entry.first);
+                auto &child = inner->children[ChunkOf(entry_hash, depth)];
+                bool unused = false;
+                child = Insert(child, entry_hash, depth + 1, std::move(entry.first), std::move(entry.second), unused);
+            }
+            return inner;
+        }
+
+        static NodePtr Erase(const NodePtr &node, std::size_t hash, unsigned depth, const Key &key, bool &removed)
+        {
+            if (node == nullptr)
+                return node;
+
+            if (!node->children.empty())
+            {
+                const std::size_t chunk = ChunkOf(hash, depth);
+                auto child = Erase(node->children[chunk], hash, depth + 1, key, removed);
+                if (!removed)
+                    return node;
+
+                auto copy = std::make_shared<Node>(*node);
+                copy->children[chunk] = std::move(child);
+                for (const auto &c : copy->children)
+                {
+                    if (c != nullptr)
+                        return copy;
+                }
+                return nullptr;
+            }
+
+            for (std::size_t i = 0; i < node->entries.size(); ++i)
+            {
+                if (node->entries[i].first == key)
+                {
+                    removed = true;
+                    if (node->entries.size() == 1)
+                        return nullptr;
+
+                    auto leaf = std::make_shared<Node>(*node);
+                    leaf->entries[i] = std::move(leaf->entries.back());
+                    leaf->entries.pop_back();
+                    return leaf;
+                }
+            }
+            return node;
+        }
+
+        NodePtr root_;
+        std::size_t size_ = 0;
+    };
+
+} // namespace util
@@ -12,7 +12,7 @@ namespace app
         return ss.str();
     }
 
-    const std::string Players::AddPlayer(const std::string &dog_id, const util::Tagged<std::string, model::GameSession> &game_session)
+    const std::string Players::AddPlayer(const std::string &dog_id, const util::Tagged<std::string, model::GameSession> &game_session, model::DogHandle dog_handle)
     {
         try
         {
@@ -26,10 +26,12 @@ namespace app
             } while (token.size() != 32);
 
             auto token_tag = util::Tagged<std::string, detail::TokenTag>(token);
-            auto new_player_ = std::make_shared<Player>(++count_players_, std::move(dog_id_tag_), game_session, token_tag);
+            auto new_player_ = std::make_shared<Player>(++count_players_, std::move(dog_id_tag_), game_session, token_tag, dog_handle);
 
+            IndexPlayer(new_player_);
             auto pair = std::make_pair<Token, std::shared_ptr<Player>>(std::move(token_tag), std::move(new_player_));
             players_.insert(pair);
+            PublishDirectory();
 
             return token;
         }
@@ -45,10 +47,96 @@ namespace app
     void Players::AddPlayer(std::shared_ptr<app::Player> player)
     {
         auto token = player->GetToken();
+        IndexPlayer(player);
         auto pair = std::make_pair<Token, std::shared_ptr<Player>>(std::move(token), std::move(player));
         players_.insert(pair);
     }
 
+    const std::vector<std::shared_ptr<Player>> &Players::GetSessionPlayers(uint32_t session_index) const
+    {
+        static const std::vector<std::shared_ptr<Player>> empty;
+
+        if (auto it = session_players_.find(session_index); it != session_players_.end())
+            return it->second;
+
+        return empty;
+    }
+
+    void Players::IndexPlayer(const std::shared_ptr<Player> &player)
+    {
+        auto &players = session_players_[player->GetDogHandle().session];
+        session_positions_[player.get()] = players.size();
+        players.push_back(player);
+
+        token_by_id_.insert_or_assign(player->GetId(), player->GetToken());
+        token_by_name_.insert_or_assign(*player->GetDogId(), player->GetToken());
+        if (player->GetDogHandle().IsValid())
+            token_by_dog_.insert_or_assign(player->GetDogHandle(), player->GetToken());
+
+        IndexDirectory(*player);
+    }
+
+    void Players::IndexDirectory(const Player &player)
+    {
+        draft_.by_token = draft_.by_token.Insert(*player.GetToken(), PlayerEntry{player.GetId(), player.GetDogHandle()});
+        if (!player.GetDogHandle().IsValid())
+            return;
+
+        draft_.id_by_dog = draft_.id_by_dog.Insert(player.GetDogHandle(), player.GetId());
+        BumpSessionVersion(player.GetDogHandle().session);
+    }
+
+    void Players::UnindexDirectory(const Player &player)
+    {
+        draft_.by_token = draft_.by_token.Erase(*player.GetToken());
+        if (!player.GetDogHandle().IsValid())
+            return;
+
+        draft_.id_by_dog = draft_.id_by_dog.Erase(player.GetDogHandle());
+        BumpSessionVersion(player.GetDogHandle().session);
+        departed_.emplace_back(player.GetDogHandle(), player.GetId());
+        draft_.departed_id_by_dog = draft_.departed_id_by_dog.Insert(player.GetDogHandle(), player.GetId());
+        if (departed_.size() > kDepartedPlayersKept)
+        {
+            draft_.departed_id_by_dog = draft_.departed_id_by_dog.Erase(departed_.front().first);
+            departed_.pop_front();
+        }
+    }
+
+    void Players::UnindexPlayer(const Player &player)
+    {
+        if (auto it = token_by_id_.find(player.GetId()); it != token_by_id_.end() && it->second == player.GetToken())
+            token_by_id_.erase(it);
+        if (auto it = token_by_name_.find(*player.GetDogId()); it != token_by_name_.end() && it->second == player.GetToken())
+            token_by_name_.erase(it);
+        if (auto it = token_by_dog_.find(player.GetDogHandle()); it != token_by_dog_.end() && it->second == player.GetToken())
+            token_by_dog_.erase(it);
+
+        auto position = session_positions_.find(&player);
+        auto it = session_players_.find(player.GetDogHandle().session);
+        if (position == session_positions_.end() || it == session_players_.end())
+            return;
+
+        auto &players = it->second;
+        const size_t index = position->second;
+        session_positions_.erase(position);
+
+        if (index + 1 != players.size())
+        {
+            players[index] = std::move(players.back());
+            session_positions_[players[index].get()] = index;
+        }
+        players.pop_back();
+
+        if (players.empty())
+            session_players_.erase(it);
+    }
+
+    void Players::BumpSessionVersion(uint32_t session_index)
+    {
+        draft_.session_versions = draft_.session_versions.Insert(session_index, draft_.SessionVersion(session_index) + 1);
+    }
+
     std::shared_ptr<Player> Players::FindByToken(std::string &str) const
     {
         Token token = util::Tagged<std::string, detail::TokenTag>(str);
@@ -60,43 +148,74 @@ namespace app
         return players_.at(token);
     }
 
-    const Token Players::FindTokenByPlayerId(uint64_t id) const
+    std::optional<Token> Players::FindTokenByPlayerId(uint64_t id) const
     {
-        for (const auto &item : players_)
-        {
-            if (item.second.get()->GetId() == id)
-                return item.first;
-        }
+        if (auto it = token_by_id_.find(id); it != token_by_id_.end())
+            return it->second;
+        return std::nullopt;
     }
 
-    const Token Players::FindTokenByName(const std::string &name) const
+    std::optional<Token> Players::FindTokenByName(const std::string &name) const
     {
-        auto name_tag_ = util::Tagged<std::string, model::Dog>(name);
-        for (const auto &item : players_)
-        {
-            if (item.second.get()->GetDogId() == name_tag_)
-                return item.first;
-        }
+        if (auto it = token_by_name_.find(name); it != token_by_name_.end())
+            return it->second;
+        return std::nullopt;
     }
 
-    void Players::DeletePlayer(uint64_t id)
+    std::optional<Token> Players::FindTokenByDogHandle(model::DogHandle dog_handle) const
     {
-        auto token = FindTokenByPlayerId(id);
+        if (auto it = token_by_dog_.find(dog_handle); it != token_by_dog_.end())
+            return it->second;
+        return std::nullopt;
+    }
 
-        auto it = players_.find(token);
+    void Players::DeletePlayer(const std::optional<Token> &token)
+    {
+        if (!token)
+            return;
+
+        auto it = players_.find(*token);
         if (it == players_.end())
             return;
 
+        UnindexDirectory(*it->second);
+        UnindexPlayer(*it->second);
         players_.erase(it);
     }
 
+    void Players::DeletePlayer(uint64_t id)
+    {
+        DeletePlayer(FindTokenByPlayerId(id));
+        PublishDirectory();
+    }
+
     void Players::DeletePlayer(DogId dog_)
     {
-        auto token = FindTokenByName(*dog_);
-        auto it = players_.find(token);
-        if (it == players_.end())
+        DeletePlayer(FindTokenByName(*dog_));
+        PublishDirectory();
+    }
+
+    void Players::DeletePlayer(model::DogHandle dog_handle)
+    {
+        DeletePlayer(FindTokenByDogHandle(dog_handle));
+        PublishDirectory();
+    }
+
+    void Players::DeletePlayers(std::span<const model::DogHandle> dog_handles)
+    {
+        if (dog_handles.empty())
             return;
 
-        players_.erase(it);
+        for (const auto &dog_handle : dog_handles)
+        {
+            DeletePlayer(FindTokenByDogHandle(dog_handle));
+        }
+        PublishDirectory();
+    }
+
+    void Players::PublishDirectory()
+    {
+        draft_.version = directory_.Load()->version + 1;
+        directory_.Store(std::make_shared<const PlayerDirectory>(draft_));
     }
-}
\ No newline at end of file
+}
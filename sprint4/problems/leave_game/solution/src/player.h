@@ -1,10 +1,17 @@
 #pragma once
 #include "tagged.h"
 #include "model.h"
+#include "atomic_snapshot.h"
+#include "persistent_map.h"
 
 #include <random>
 #include <map>
 #include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <deque>
 
 namespace detail
 {
@@ -45,10 +52,11 @@ namespace app
     class Player
     {
     public:
-        Player(uint64_t id, DogId dog, GameSessionId game_session, Token token) : id_{id},
-                                                                                  dog_{dog},
-                                                                                  game_session_{game_session},
-                                                                                  token_{token} {};
+        Player(uint64_t id, DogId dog, GameSessionId game_session, Token token, model::DogHandle dog_handle = {}) : id_{id},
+                                                                                                                    dog_{dog},
+                                                                                                                    game_session_{game_session},
+                                                                                                                    token_{token},
+                                                                                                                    dog_handle_{dog_handle} {};
 
         const DogId &GetDogId() const noexcept
         {
@@ -70,36 +78,153 @@ namespace app
             return token_;
         }
 
+        // Ссылка на собаку для обработки запросов; имена собаки и сессии нужны только для вывода и сохранения
+        model::DogHandle GetDogHandle() const noexcept
+        {
+            return dog_handle_;
+        }
+
+        void SetDogHandle(model::DogHandle dog_handle) noexcept
+        {
+            dog_handle_ = dog_handle;
+        }
+
     private:
         uint64_t id_;
         DogId dog_;
         GameSessionId game_session_;
         Token token_;
+        model::DogHandle dog_handle_;
+    };
+
+    struct DogHandleHasher
+    {
+        size_t operator()(const model::DogHandle &handle) const noexcept
+        {
+            const uint64_t key = (static_cast<uint64_t>(handle.session) << 32) ^ (static_cast<uint64_t>(handle.slot) << 11) ^ handle.generation;
+            return std::hash<uint64_t>{}(key);
+        }
+    };
+
+    struct PlayerEntry
+    {
+        uint64_t id = 0;
+        model::DogHandle dog_handle;
+    };
+
+    // Сколько ушедших игроков справочник помнит, чтобы ответы ?since= могли назвать их id
+    constexpr size_t kDepartedPlayersKept = 1024;
+
+    /*
+     *  Неизменяемый справочник игроков для чтения без блокировок: токен -> игрок, собака -> id игрока.
+     *  Таблицы персистентные: новая версия справочника делит с прежней все узлы, кроме изменённых путей.
+     */
+    struct PlayerDirectory
+    {
+        using IdByDog = util::PersistentHashMap<model::DogHandle, uint64_t, DogHandleHasher>;
+
+        // Растёт при каждой публикации
+        uint64_t version = 0;
+        util::PersistentHashMap<std::string, PlayerEntry> by_token;
+        IdByDog id_by_dog;
+        IdByDog departed_id_by_dog;
+        // Версии по игровым сессиям растут при входе и уходе игроков сессии; входят в ключ кеша ответов /state
+        util::PersistentHashMap<uint32_t, uint64_t> session_versions;
+
+        uint64_t SessionVersion(uint32_t session_index) const
+        {
+            const uint64_t *session_version = session_versions.Find(session_index);
+            return session_version == nullptr ? 0 : *session_version;
+        }
+
+        const PlayerEntry *FindByToken(const std::string &token) const
+        {
+            return by_token.Find(token);
+        }
+
+        // Сессия собаки игрока; nullopt для неизвестного токена или игрока без собаки
+        std::optional<uint32_t> FindSession(const std::string &token) const
+        {
+            const PlayerEntry *entry = FindByToken(token);
+            if (entry == nullptr || !entry->dog_handle.IsValid())
+                return std::nullopt;
+            return entry->dog_handle.session;
+        }
+
+        // id игрока собаки, в том числе недавно ушедшего
+        std::optional<uint64_t> FindPlayerId(const model::DogHandle &dog_handle) const
+        {
+            if (const uint64_t *id = id_by_dog.Find(dog_handle))
+                return *id;
+            if (const uint64_t *id = departed_id_by_dog.Find(dog_handle))
+                return *id;
+            return std::nullopt;
+        }
     };
 
     class Players
     {
     public:
-        const std::string AddPlayer(const std::string &dog_id, const GameSessionId &game_session);
+        const std::string AddPlayer(const std::string &dog_id, const GameSessionId &game_session, model::DogHandle dog_handle = {});
+        // Массовая загрузка: справочник не публикуется, после загрузки нужно вызвать PublishDirectory
         void AddPlayer(std::shared_ptr<app::Player> player);
 
+        // Удаление по идентификатору игрока, имени или ссылке на собаку работает через индексы за O(1)
         void DeletePlayer(uint64_t id);
         void DeletePlayer(DogId dog_);
+        void DeletePlayer(model::DogHandle dog_handle);
+        // Удаляет всех игроков собак и публикует справочник один раз
+        void DeletePlayers(std::span<const model::DogHandle> dog_handles);
+
+        // Справочник правится точечно при входе и уходе игроков, публикация стоит O(1) независимо от их числа
+        std::shared_ptr<const PlayerDirectory> GetDirectory() const noexcept
+        {
+            return directory_.Load();
+        }
+
+        void PublishDirectory();
 
         std::shared_ptr<Player> FindByToken(std::string &str) const;
         std::shared_ptr<Player> FindByToken(Token &token) const;
 
-        const Token FindTokenByPlayerId(uint64_t id) const;
+        std::optional<Token> FindTokenByPlayerId(uint64_t id) const;
+
+        std::optional<Token> FindTokenByName(const std::string &name) const;
 
-        const Token FindTokenByName(const std::string &name) const;
+        std::optional<Token> FindTokenByDogHandle(model::DogHandle dog_handle) const;
 
         const std::map<Token, std::shared_ptr<Player>> &GetPlayers() const noexcept
         {
             return players_;
         }
 
+        // Игроки одной игровой сессии по её индексу в model::Game (DogHandle::session)
+        const std::vector<std::shared_ptr<Player>> &GetSessionPlayers(uint32_t session_index) const;
+
     private:
+        using SessionPlayers = std::unordered_map<uint32_t, std::vector<std::shared_ptr<Player>>>;
+
+        void IndexPlayer(const std::shared_ptr<Player> &player);
+        void UnindexPlayer(const Player &player);
+        void IndexDirectory(const Player &player);
+        void UnindexDirectory(const Player &player);
+        void BumpSessionVersion(uint32_t session_index);
+        void DeletePlayer(const std::optional<Token> &token);
+
         uint64_t count_players_ = 0;
         std::map<Token, std::shared_ptr<Player>> players_;
+        SessionPlayers session_players_;
+
+        // Место игрока в векторе игроков его сессии, чтобы удалять его перестановкой с последним
+        std::unordered_map<const Player *, size_t> session_positions_;
+        std::unordered_map<uint64_t, Token> token_by_id_;
+        std::unordered_map<std::string, Token> token_by_name_;
+        std::unordered_map<model::DogHandle, Token, DogHandleHasher> token_by_dog_;
+        // Последние ушедшие игроки (собака, id), не больше kDepartedPlayersKept
+        std::deque<std::pair<model::DogHandle, uint64_t>> departed_;
+
+        // Черновик следующей версии справочника, правится вместе с индексами выше
+        PlayerDirectory draft_;
+        util::AtomicSnapshot<PlayerDirectory> directory_{std::make_shared<const PlayerDirectory>()};
     };
 }
\ No newline at end of file
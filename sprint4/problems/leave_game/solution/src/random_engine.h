@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+
+namespace util
+{
+    /*
+     *  Быстрый генератор псевдослучайных чисел xoshiro256++ с состоянием из 32 байт.
+     *  Удовлетворяет требованиям UniformRandomBitGenerator, поэтому подходит для std-распределений.
+     *  Состояние можно сохранить и восстановить, чтобы повторить последовательность.
+     */
+    class RandomEngine
+    {
+    public:
+        using result_type = uint64_t;
+        using State = std::array<uint64_t, 4>;
+
+        explicit RandomEngine(uint64_t seed = 0) noexcept
+        {
+            Seed(seed);
+        }
+
+        static constexpr result_type min() noexcept
+        {
+            return 0;
+        }
+
+        static constexpr result_type max() noexcept
+        {
+            return std::numeric_limits<result_type>::max();
+        }
+
+        // Заполняет состояние из одного числа через splitmix64, как рекомендуют авторы xoshiro
+        void Seed(uint64_t seed) noexcept
+        {
+            for (auto &word : state_)
+            {
+                seed += 0x9e3779b97f4a7c15ULL;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                word = z ^ (z >> 31);
+            }
+        }
+
+        const State &GetState() const noexcept
+        {
+            return state_;
+        }
+
+        void SetState(const State &state) noexcept
+        {
+            state_ = state;
+        }
+
+        result_type operator()() noexcept
+        {
+            const uint64_t result = Rotl(state_[0] + state_[3], 23) + state_[0];
+            const uint64_t t = state_[1] << 17;
+
+            state_[2] ^= state_[0];
+            state_[3] ^= state_[1];
+            state_[1] ^= state_[2];
+            state_[0] ^= state_[3];
+            state_[2] ^= t;
+            state_[3] = Rotl(state_[3], 45);
+
+            return result;
+        }
+
+        // Число в диапазоне [0, 1)
+        double NextDouble() noexcept
+        {
+            return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+        }
+
+        // Целое число в диапазоне [start, end], границы можно передавать в любом порядке
+        int32_t NextInt(int32_t start, int32_t end) noexcept
+        {
+            if (start > end)
+                std::swap(start, end);
+
+            const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(end) - start) + 1;
+            // Умножение со сдвигом вместо деления по модулю; смещение для диапазонов < 2^32 пренебрежимо мало
+            const uint64_t scaled = static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * range) >> 64);
+            return static_cast<int32_t>(start + static_cast<int64_t>(scaled));
+        }
+
+        // Заполняет out числами из [0, 1)
+        void FillDoubles(std::span<double> out) noexcept
+        {
+            for (double &value : out)
+                value = NextDouble();
+        }
+
+        // Заполняет out целыми числами из [start, end]
+        void FillInts(std::span<int32_t> out, int32_t start, int32_t end) noexcept
+        {
+            for (int32_t &value : out)
+                value = NextInt(start, end);
+        }
+
+    private:
+        static uint64_t Rotl(uint64_t x, int k) noexcept
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        State state_{};
+    };
+
+} // namespace util
@@ -18,6 +18,101 @@ namespace http_handler
         return json::serialize(error);
     }    
 
+    RequestHandler::ApiRoute RequestHandler::RouteOf(const std::string &path)
+    {
+        const std::string_view route = std::string_view{path}.substr(0, path.find('?'));
+
+        if (route.starts_with("api/v1/maps"sv) || route.starts_with("api/v1/game/records"sv))
+            return ApiRoute::READ_ONLY;
+
+        if (route.starts_with("api/v1/game/players"sv) || route.starts_with("api/v1/game/state"sv))
+            return ApiRoute::SNAPSHOT;
+
+        if (route.starts_with("api/v1/game/player/action"sv))
+            return ApiRoute::SESSION;
+
+        return ApiRoute::GLOBAL;
+    }
+
+    std::optional<uint32_t> RequestHandler::ResolveSession(const StringRequest &req)
+    {
+        const auto header = req.find(http::field::authorization);
+        if (header == req.end() || !header->value().starts_with("Bearer "))
+            return std::nullopt;
+
+        std::string token{header->value().substr(header->value().find(' ') + 1)};
+
+        // Справочник не бросает исключений на неизвестный токен: такой запрос получит 401 от ResponseApi
+        return players_.GetDirectory()->FindSession(token);
+    }
+
+    void RequestHandler::Upgrade(tcp::socket &&socket, StringRequest &&req)
+    {
+        const auto directory = players_.GetDirectory();
+        auto check = StateStream::CheckUpgrade(req, *directory);
+        if (check.player == nullptr)
+            return StateStream::RejectUpgrade(std::move(socket), req, check.status, Error(check.code, check.message));
+
+        const auto *player = check.player;
+        std::string token = std::move(check.token);
+
+        // Входящие кадры - тела запросов действия игрока, они проходят обычный путь через strand сессии
+        auto on_command = [weak = weak_from_this(), token](std::string command, StateStreamSession::Reply reply)
+        {
+            auto self = weak.lock();
+            if (self == nullptr)
+                return;
+
+            StringRequest action{http::verb::post, "/api/v1/game/player/action", 11};
+            action.set(http::field::authorization, "Bearer " + token);
+            action.set(http::field::content_type, ContentType::TEXT_JSON);
+            action.body() = std::move(command);
+            action.prepare_payload();
+
+            (*self)(std::move(action), [reply](auto &&response)
+                    {
+                        // Успешные действия видны в следующих кадрах состояния, клиенту отправляются только ошибки
+                        if constexpr (std::is_same_v<std::decay_t<decltype(response)>, StringResponse>)
+                        {
+                            if (response.result() != http::status::ok)
+                                reply(response.body());
+                        } });
+        };
+
+        const uint32_t session_index = player->dog_handle.session;
+        auto stream = std::make_shared<StateStreamSession>(std::move(socket), std::move(token), std::move(on_command));
+        state_stream_.Subscribe(session_index, stream);
+
+        // Первый кадр уходит сразу после рукопожатия, не дожидаясь тика
+        if (auto frame = MakeStateFrame(session_index, *directory))
+            stream->Push(std::move(frame));
+
+        stream->Run(std::move(req));
+    }
+
+    void RequestHandler::PublishState()
+    {
+        const auto directory = players_.GetDirectory();
+
+        for (const uint32_t session_index : state_stream_.GetSubscribedSessions())
+        {
+            if (auto frame = MakeStateFrame(session_index, *directory))
+                state_stream_.Broadcast(session_index, frame, *directory);
+        }
+    }
+
+    StateStreamSession::Frame RequestHandler::MakeStateFrame(uint32_t session_index, const app::PlayerDirectory &directory)
+    {
+        const auto snapshot = game_.GetSessionSnapshot(session_index);
+        if (snapshot == nullptr)
+            return nullptr;
+
+        // Кадр - то же тело, что отдаёт /state: одна сериализация на тик для HTTP и WebSocket
+        return state_cache_.Get(session_index, snapshot->tick, directory.SessionVersion(session_index), [&]
+                                { return ResponseApi::StateJson(*snapshot, directory); })
+            ->body;
+    }
+
     RequestHandler::StringResponse RequestHandler::MakeStringResponse(http::status status, std::string_view body, unsigned http_version, bool keep_alive, std::string_view content_type) 
     {
         StringResponse response(status, http_version);
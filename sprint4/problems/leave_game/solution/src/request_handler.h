@@ -7,6 +7,8 @@
 #include "model.h"
 #include "loots.h"
 #include "application.h"
+#include "session_strands.h"
+#include "state_stream.h"
 
 #include <boost/json.hpp>
 #include <boost/algorithm/string.hpp>
@@ -76,13 +78,20 @@ namespace http_handler
               application_{application},
               game_loots_{game_loots},
               game_file_path_(game_file_path),
-              api_strand_{api_strand}
+              api_strand_{api_strand},
+              session_strands_{api_strand.get_inner_executor()}
         {
         }
 
         RequestHandler(const RequestHandler &) = delete;
         RequestHandler &operator=(const RequestHandler &) = delete;
 
+        // Запрос Upgrade на /api/v1/game/stream открывает WebSocket-подписку на состояние сессии игрока
+        void Upgrade(tcp::socket &&socket, StringRequest &&req);
+
+        // Рассылает подписчикам состояние их сессий; вызывается после тика вне блокировки игры
+        void PublishState();
+
         template <typename Body, typename Allocator, typename Send>
         void operator()(http::request<Body, http::basic_fields<Allocator>> &&req, Send &&send)
         {
@@ -96,13 +105,44 @@ namespace http_handler
 
             if (std::strstr(url.data(), "api"))
             {
-                auto handle = [self = shared_from_this(), send, req = std::forward<decltype(req)>(req), str]
+                const ApiRoute route = RouteOf(str);
+                std::optional<uint32_t> session_index;
+                if (route == ApiRoute::SESSION)
+                {
+                    session_index = ResolveSession(req);
+                }
+
+                auto handle = [self = shared_from_this(), send, req = std::forward<decltype(req)>(req), str, route]
                 {
-                    auto api = std::make_shared<ResponseApi>(self->game_, self->players_, self->game_loots_, self->application_);
-                    auto res = api->Request(std::move(req), str);
-                    return send(res);
+                    // Операции над всей игрой исключают запросы к сессиям, запросы к сессиям друг другу не мешают
+                    // Чтение опубликованных снимков блокировок не берёт
+                    std::shared_lock<std::shared_mutex> shared_lock;
+                    std::unique_lock<std::shared_mutex> exclusive_lock;
+                    if (route == ApiRoute::GLOBAL)
+                        exclusive_lock = self->application_.LockExclusive();
+                    else if (route != ApiRoute::SNAPSHOT)
+                        shared_lock = self->application_.LockShared();
+
+                    auto api = std::make_shared<ResponseApi>(self->game_, self->players_, self->game_loots_, self->application_, self->state_cache_);
+                    api->RequestAsync(std::move(req), str, self->api_strand_, [send](auto res)
+                                      { std::visit([&send](auto &&response)
+                                                   { send(std::move(response)); },
+                                                   std::move(res)); });
+
+                    // Вход в игру и ручной тик меняют состояние: подписчики узнают о нём сразу
+                    if (route == ApiRoute::GLOBAL)
+                    {
+                        exclusive_lock.unlock();
+                        self->PublishState();
+                    }
                 };
-                return net::dispatch(api_strand_, handle);
+
+                if (session_index)
+                    return net::dispatch(session_strands_.Get(*session_index), std::move(handle));
+                if (route == ApiRoute::GLOBAL)
+                    return net::dispatch(api_strand_, std::move(handle));
+                // Чтение неизменяемых данных и запросы с неизвестным токеном не требуют strand
+                return handle();
             }
 
             // Возвращаем результат обработки запроса к файлу
@@ -115,6 +155,24 @@ namespace http_handler
         }
 
     private:
+        enum class ApiRoute
+        {
+            // Карты и рекорды: данные не меняются или защищены собственной синхронизацией
+            READ_ONLY,
+            // Список игроков и состояние: читаются из опубликованных снимков без strand и блокировок
+            SNAPSHOT,
+            // Действия игрока: выполняются в strand его сессии
+            SESSION,
+            // Вход в игру, тик и служебные запросы: исключительная блокировка в api_strand
+            GLOBAL
+        };
+
+        static ApiRoute RouteOf(const std::string &path);
+        // Кадр состояния сессии из общего кеша; nullptr, если сессии нет
+        StateStreamSession::Frame MakeStateFrame(uint32_t session_index, const app::PlayerDirectory &directory);
+        // Индекс сессии игрока по токену из заголовка Authorization
+        std::optional<uint32_t> ResolveSession(const StringRequest &req);
+
         FileRequestResult RequestFile(const StringRequest &req, fs::path path);
         StringResponse ReportServerError(const StringRequest &req);
 
@@ -134,6 +192,10 @@ namespace http_handler
 
         const fs::path game_file_path_;
         Strand api_strand_;
+        SessionStrands session_strands_;
+        // Сериализованное состояние сессий, общее для всех запросов /state
+        StateCache state_cache_;
+        StateStream state_stream_;
 
         const std::map<std::string, std::string_view> map_extension = {
             {".json", ContentType::TEXT_JSON},
@@ -152,7 +152,7 @@ namespace http_handler
 
     bool ResponseApi::GetMap(const std::string id_map, std::string &&res)
     {
-        const model::Map *data_map = nullptr;
+        std::shared_ptr<const model::Map> data_map = nullptr;
 
         if (id_map == "maps" || id_map.empty())
         {
@@ -193,15 +193,15 @@ namespace http_handler
 
     void ResponseApi::GetAllMaps(std::string &&res) const
     {
-        auto all_maps = game_.GetMaps();
+        const auto &all_maps = game_.GetMaps();
 
         boost::json::array maps_array;
         for (const auto &map : all_maps)
         {
             boost::json::object map_obj =
                 {
-                    {kId, *map.GetId()},
-                    {kName, map.GetName()},
+                    {kId, *map->GetId()},
+                    {kName, map->GetName()},
                 };
 
             maps_array.push_back(map_obj);
@@ -210,35 +210,44 @@ namespace http_handler
         res = json::serialize(maps_array);
     }
 
-    std::shared_ptr<app::Player> ResponseApi::Authorization(const StringRequest &req, StringResponse &&res)
+    std::optional<std::string> ResponseApi::ExtractToken(const StringRequest &req, StringResponse &res)
     {
-        try
+        std::string token = std::string();
+
+        for (const auto &h : req.base())
         {
-            std::string token = std::string();
+            const boost::beast::string_view name = h.name_string();
 
-            for (const auto &h : req.base())
+            if (name == "Authorization" || name == "authorization")
             {
-                const boost::beast::string_view name = h.name_string();
-
-                if (name == "Authorization" || name == "authorization")
+                if (!h.value().starts_with("Bearer"))
                 {
-                    if (!h.value().starts_with("Bearer"))
-                    {
-                        res = MakeStringResponse(http::status::unauthorized, Error("Invalid Token", "Authorization header is required"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
-                        return nullptr;
-                    }
-
-                    token = h.value().substr(h.value().find(' ') + 1, h.value().size());
+                    res = MakeStringResponse(http::status::unauthorized, Error("Invalid Token", "Authorization header is required"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+                    return std::nullopt;
                 }
+
+                token = h.value().substr(h.value().find(' ') + 1, h.value().size());
             }
+        }
 
-            if (token.empty() || token.size() != 32)
-            {
-                res = MakeStringResponse(http::status::unauthorized, Error("Invalid Token", "Authorization header is missing"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+        if (token.empty() || token.size() != 32)
+        {
+            res = MakeStringResponse(http::status::unauthorized, Error("Invalid Token", "Authorization header is missing"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+            return std::nullopt;
+        }
+
+        return token;
+    }
+
+    std::shared_ptr<app::Player> ResponseApi::Authorization(const StringRequest &req, StringResponse &&res)
+    {
+        try
+        {
+            auto token = ExtractToken(req, res);
+            if (!token)
                 return nullptr;
-            }
 
-            auto player = players_.FindByToken(token);
+            auto player = players_.FindByToken(*token);
 
             if (player == nullptr)
             {
@@ -255,6 +264,20 @@ namespace http_handler
         }
     }
 
+    const app::PlayerEntry *ResponseApi::AuthorizeSnapshot(const StringRequest &req, const app::PlayerDirectory &directory, StringResponse &res)
+    {
+        auto token = ExtractToken(req, res);
+        if (!token)
+            return nullptr;
+
+        const auto *entry = directory.FindByToken(*token);
+        if (entry == nullptr)
+        {
+            res = MakeStringResponse(http::status::unauthorized, Error("Unknown Token", "Player token has not been found"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+        }
+        return entry;
+    }
+
     ResponseApi::StringResponse ResponseApi::Tick(const StringRequest &req)
     {
         if (req.method() != boost::beast::http::verb::post)
@@ -278,6 +301,7 @@ namespace http_handler
             return (MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Invalid Argument"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
 
         game_.Tick(std::chrono::milliseconds(time), game_loots_);
+        application_.RemoveRetiredPlayers();
         application_.SaveGameState(std::chrono::milliseconds(time));
 
         json::object obj = {};
@@ -311,9 +335,9 @@ namespace http_handler
             return (MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Failed to parse action"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
         }
 
-        auto game_session_id_ = player_->GetGameSessionId();
-        auto session_ = game_.FindGameSession(game_session_id_);
-        auto dog_ = session_->FindDog(player_->GetDogId());
+        const auto dog_handle_ = player_->GetDogHandle();
+        auto session_ = game_.GetGameSession(dog_handle_.session);
+        auto dog_ = session_ == nullptr ? nullptr : session_->FindDog(dog_handle_);
 
         if (dog_ == nullptr)
             return (MakeStringResponse(http::status::not_found, Error("Invalid Argument", "Not found dog in Game Session"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
@@ -325,7 +349,7 @@ namespace http_handler
         return MakeStringResponse(http::status::ok, json::serialize(obj), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
     }
 
-    ResponseApi::StringResponse ResponseApi::State(const StringRequest &req)
+    ResponseApi::ApiResponse ResponseApi::State(const StringRequest &req)
     {
         if (req.method() != boost::beast::http::verb::get && req.method() != boost::beast::http::verb::head)
         {
@@ -334,92 +358,204 @@ namespace http_handler
 
         StringResponse res;
 
-        auto player_ = Authorization(req, std::move(res));
+        // Справочник игроков и снимок сессии читаются без блокировок и strand: опрос состояния не задерживает тик
+        const auto directory_ = players_.GetDirectory();
+        const auto *player_ = AuthorizeSnapshot(req, *directory_, res);
 
         if (player_ == nullptr)
             return res;
 
-        auto allPlayers = players_.GetPlayers();
-
         try
         {
-            json::object players_array_;
+            // Состояние только своей сессии: стоимость ответа не зависит от числа шардов карты
+            const auto session_index_ = player_->dog_handle.session;
+            const auto snapshot_ = game_.GetSessionSnapshot(session_index_);
+
+            if (snapshot_ == nullptr)
+                return (MakeStringResponse(http::status::not_found, Error("Invalid Argument", "Not found Game Session"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
 
-            for (const auto &current_player : allPlayers)
+            // ?since=<тик>: только изменения после тика, который клиент уже видел
+            const auto params_ = boost::urls::url_view{req.target()}.params();
+            if (const auto since_it_ = params_.find("since"sv); since_it_ != params_.end())
             {
-                auto game_session_id_ = current_player.second.get()->GetGameSessionId();
-                auto dog_ = game_.FindGameSession(game_session_id_)->FindDog(current_player.second.get()->GetDogId());
+                uint64_t since_ = 0;
+                try
+                {
+                    since_ = std::stoull((*since_it_).value);
+                }
+                catch (...)
+                {
+                    return MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "since must be a tick number"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+                }
 
-                if (dog_ == nullptr)
-                    return (MakeStringResponse(http::status::not_found, Error("Invalid Argument", "Invalid Argument"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
+                return MakeStringResponse(http::status::ok, StateDeltaJson(*snapshot_, *directory_, since_), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+            }
 
-                json::array obj_bag_;
+            // Тело сериализуется один раз на тик и отдаётся всем игрокам сессии
+            const auto cached_ = state_cache_.Get(session_index_, snapshot_->tick, directory_->SessionVersion(session_index_), [&]
+                                                  { return StateJson(*snapshot_, *directory_); });
 
-                auto bag_ = dog_->GetBag();
-                for (const auto &item : bag_)
+            if (StateCache::Matches(req[http::field::if_none_match], cached_->etag))
+            {
+                StringResponse not_modified_{http::status::not_modified, req.version()};
+                not_modified_.set(http::field::etag, cached_->etag);
+                not_modified_.set(http::field::cache_control, "no-cache"sv);
+                not_modified_.keep_alive(req.keep_alive());
+                return not_modified_;
+            }
+
+            SharedResponse shared_{http::status::ok, req.version()};
+            shared_.set(http::field::content_type, ContentType::TEXT_JSON);
+            shared_.set(http::field::cache_control, "no-cache"sv);
+            shared_.set(http::field::etag, cached_->etag);
+            shared_.body() = cached_->body;
+            shared_.prepare_payload();
+            shared_.keep_alive(req.keep_alive());
+            return shared_;
+        }
+        catch (...)
+        {
+            return MakeStringResponse(http::status::ok, Error("Exception", "Exception in state responce"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+        }
+    }
+
+    json::object ResponseApi::DogStateObject(const model::DogSnapshot &dog)
+    {
+        json::array obj_bag_;
+
+        for (const auto &item : dog.bag)
+        {
+            json::object obj_item =
                 {
-                    json::object obj_item =
-                        {
-                            {kId, item.id_},
-                            {kType, item.type_}};
-                    obj_bag_.push_back(obj_item);
-                }
+                    {kId, item.id_},
+                    {kType, item.type_}};
+            obj_bag_.push_back(obj_item);
+        }
 
-                json::array dog_position_;
+        json::array dog_position_;
 
-                dog_position_.push_back(std::round(dog_->GetPosition().x * 10000.0) / 10000.0);
-                dog_position_.push_back(std::round(dog_->GetPosition().y * 10000.0) / 10000.0);
+        dog_position_.push_back(std::round(dog.position.x * 10000.0) / 10000.0);
+        dog_position_.push_back(std::round(dog.position.y * 10000.0) / 10000.0);
 
-                json::array dog_speed_;
-                dog_speed_.push_back(dog_->GetSpeed().x);
-                dog_speed_.push_back(dog_->GetSpeed().y);
+        json::array dog_speed_;
+        dog_speed_.push_back(dog.speed.x);
+        dog_speed_.push_back(dog.speed.y);
 
-                json::object obj =
-                    {
-                        {kPos, dog_position_},
-                        {kSpeed, dog_speed_},
-                        {kDir, dog_->GetDirection()},
-                        {kBag, obj_bag_},
-                        {kScore, dog_->GetScore()},
-                    };
+        return {
+            {kPos, dog_position_},
+            {kSpeed, dog_speed_},
+            {kDir, dog.direction},
+            {kBag, obj_bag_},
+            {kScore, dog.score},
+        };
+    }
 
-                players_array_.emplace(std::to_string(current_player.second->GetId()), obj);
-            }
+    json::object ResponseApi::LootStateObject(const model::MapLoot &loot)
+    {
+        json::array pos;
+        pos.push_back(loot.position_x_);
+        pos.push_back(loot.position_y_);
 
-            // TO DO! Сессия должна быть одна                         Возможна ошибка `.at(0)`! Аккуратно!
-            auto game_session = game_.GetGameSessions().at(0);
-            auto all_loots_ = game_session->GetMap().GetLoots();
+        return {
+            {kType, loot.type_},
+            {kPos, pos},
+        };
+    }
 
-            json::object loots_array_;
-            loots_array_.reserve(all_loots_.size());
+    json::object ResponseApi::StateObject(const model::SessionSnapshot &snapshot, const app::PlayerDirectory &directory, bool &complete)
+    {
+        json::object players_array_;
+        players_array_.reserve(snapshot.dogs.size());
 
-            for (const auto &loot : all_loots_)
+        for (const auto &dog_ : snapshot.dogs)
+        {
+            // Собака, чей игрок ещё не попал в справочник, появится в следующем ответе
+            const uint64_t *player_id_ = directory.id_by_dog.Find(dog_.handle);
+            if (player_id_ == nullptr)
             {
-                json::array pos;
-                pos.push_back(loot.position_x_);
-                pos.push_back(loot.position_y_);
+                complete = false;
+                continue;
+            }
 
-                json::object obj =
-                    {
-                        {kType, loot.type_},
-                        {kPos, pos},
-                    };
+            players_array_.emplace(std::to_string(*player_id_), DogStateObject(dog_));
+        }
 
-                loots_array_.emplace(std::to_string(loot.id_), obj);
-            }
+        json::object loots_array_;
+        loots_array_.reserve(snapshot.loots.size());
 
-            json::object players_obj_ =
-                {
-                    {kPlayers, players_array_},
-                    {kLostObjects, loots_array_},
-                };
+        for (const auto &loot : snapshot.loots)
+        {
+            loots_array_.emplace(std::to_string(loot.id_), LootStateObject(loot));
+        }
+
+        return {
+            {kPlayers, players_array_},
+            {kLostObjects, loots_array_},
+        };
+    }
+
+    std::string ResponseApi::StateJson(const model::SessionSnapshot &snapshot, const app::PlayerDirectory &directory)
+    {
+        bool complete_ = true;
+        return json::serialize(StateObject(snapshot, directory, complete_));
+    }
 
-            return MakeStringResponse(http::status::ok, json::serialize(players_obj_), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+    std::string ResponseApi::StateDeltaJson(const model::SessionSnapshot &snapshot, const app::PlayerDirectory &directory, uint64_t since)
+    {
+        // Если у собаки ещё нет игрока в справочнике, курсор не продвигается: клиент получит её следующим запросом
+        bool complete_ = true;
+        const auto delta_ = snapshot.DeltaSince(since);
+
+        if (!delta_)
+        {
+            // История не покрывает since: отдаём полный снимок
+            auto full_ = StateObject(snapshot, directory, complete_);
+            full_["tick"] = complete_ ? snapshot.tick : 0;
+            full_["full"] = true;
+            return json::serialize(full_);
         }
-        catch (...)
+
+        json::object players_array_;
+        players_array_.reserve(delta_->changed_dogs.size());
+        for (const auto &dog_ : delta_->changed_dogs)
         {
-            return MakeStringResponse(http::status::ok, Error("Exception", "Exception in state responce"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+            if (const auto player_id_ = directory.FindPlayerId(dog_.handle))
+                players_array_.emplace(std::to_string(*player_id_), DogStateObject(dog_));
+            else
+                complete_ = false;
+        }
+
+        json::array removed_players_;
+        for (const auto &handle_ : delta_->removed_dogs)
+        {
+            if (const auto player_id_ = directory.FindPlayerId(handle_))
+                removed_players_.push_back(*player_id_);
         }
+
+        json::object loots_array_;
+        loots_array_.reserve(delta_->changed_loots.size());
+        for (const auto &loot : delta_->changed_loots)
+        {
+            loots_array_.emplace(std::to_string(loot.id_), LootStateObject(loot));
+        }
+
+        json::array removed_loots_;
+        for (const int id : delta_->removed_loots)
+        {
+            removed_loots_.push_back(id);
+        }
+
+        json::object delta_obj_ =
+            {
+                {"tick", complete_ ? delta_->tick : since},
+                {"full", false},
+                {kPlayers, players_array_},
+                {"removedPlayers", removed_players_},
+                {kLostObjects, loots_array_},
+                {"removedLostObjects", removed_loots_},
+            };
+
+        return json::serialize(delta_obj_);
     }
 
     ResponseApi::StringResponse ResponseApi::JoinGame(const StringRequest &req)
@@ -452,12 +588,13 @@ namespace http_handler
 
         try
         {
-            auto session_ = game_.ConnectToSession(map_id, user_name.data());
+            const auto dog_handle_ = game_.ConnectToSession(map_id, user_name.data());
+            auto session_ = game_.GetGameSession(dog_handle_.session);
 
             if (session_ == nullptr)
                 return MakeStringResponse(http::status::bad_request, Error("Bad Request", "Bad request"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
 
-            std::string token_new_player_ = players_.AddPlayer(std::move(user_name.data()), session_->GetId());
+            std::string token_new_player_ = players_.AddPlayer(std::move(user_name.data()), session_->GetId(), dog_handle_);
 
             if (token_new_player_.empty())
                 return MakeStringResponse(http::status::bad_request, Error("Bad Request", "Bad request"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
@@ -481,20 +618,23 @@ namespace http_handler
 
         StringResponse res;
 
-        auto player_ = Authorization(req, std::move(res));
+        const auto directory_ = players_.GetDirectory();
+        const auto *player_ = AuthorizeSnapshot(req, *directory_, res);
 
         if (player_ == nullptr)
             return res;
 
-        auto game_session_id_ = player_->GetGameSessionId();
-        auto all_dogs_ = game_.FindGameSession(game_session_id_)->GetDogs();
+        const auto snapshot_ = game_.GetSessionSnapshot(player_->dog_handle.session);
+        if (snapshot_ == nullptr)
+            return (MakeStringResponse(http::status::not_found, Error("Invalid Argument", "Not found Game Session"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
 
-        json::array obj{all_dogs_.size()};
+        json::array obj;
+        obj.reserve(snapshot_->dogs.size());
 
-        for (const auto &dog : all_dogs_)
+        for (const auto &dog : snapshot_->dogs)
         {
             json::object name;
-            name["name"] = *dog->GetId();
+            name["name"] = dog.name;
 
             obj.push_back(name);
         }
@@ -502,15 +642,15 @@ namespace http_handler
         return MakeStringResponse(http::status::ok, json::serialize(obj), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
     }
 
-    ResponseApi::StringResponse ResponseApi::Records(const StringRequest &req)
+    void ResponseApi::Records(const StringRequest &req, net::any_io_executor executor, Sender send)
     {
         if (req.method() != boost::beast::http::verb::get && req.method() != boost::beast::http::verb::head)
-            return (MakeStringResponse(http::status::method_not_allowed, Error("Invalid Method", "Only POST method is expected"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv, "GET, HEAD"sv));
+            return send(MakeStringResponse(http::status::method_not_allowed, Error("Invalid Method", "Only POST method is expected"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv, "GET, HEAD"sv));
 
         auto db_ = game_.GetDB();
         if (db_ == nullptr)
         {
-            return (MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Failed to parse action"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
+            return send(MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Failed to parse action"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
         }
 
         const std::string_view start_key = "start";
@@ -540,7 +680,9 @@ namespace http_handler
                 auto curr_limit = std::stoi((*it).value);
 
                 if (curr_limit > limit)
-                    return (MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Limit error"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
+                    return send(MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Limit error"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
+
+                limit = curr_limit;
             }
         }
         catch (...)
@@ -548,33 +690,259 @@ namespace http_handler
             limit = database::DEFAULT_LIMIT;
         }
 
-        auto player_records_ = db_->GetPlayerRecords();
+        // Постраничный вывод по ключу: afterScore, afterPlayTime и afterName - последняя запись предыдущей страницы
+        const auto after_score_ = params.find("afterScore"sv);
+        const auto after_play_time_ = params.find("afterPlayTime"sv);
+        const auto after_name_ = params.find("afterName"sv);
+        std::optional<database::PlayerRecord> cursor_;
 
-        std::vector<std::tuple<std::string, size_t, int64_t>> vec;
-        vec.reserve(limit);
+        if (after_score_ != params.end() || after_play_time_ != params.end() || after_name_ != params.end())
+        {
+            try
+            {
+                if (after_score_ == params.end() || after_play_time_ == params.end() || after_name_ == params.end())
+                    throw std::invalid_argument("Incomplete cursor");
+
+                cursor_.emplace(std::string((*after_name_).value), std::stoull((*after_score_).value), std::stoll((*after_play_time_).value));
+            }
+            catch (...)
+            {
+                return send(MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Cursor error"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
+            }
+        }
 
-        for (const auto &record : player_records_.GetRecordsTable(start, limit))
+        // Страница из таблицы в памяти; в базу идём, только если она выходит за хранимые строки
+        auto &leaderboard_ = db_->GetLeaderboard();
+        const auto page_ = cursor_ ? leaderboard_.GetPageAfter(*cursor_, limit, RecordsJson) : leaderboard_.GetPage(start, limit, RecordsJson);
+        if (page_)
         {
-            vec.push_back(std::make_tuple(record.GetName(), record.GetScore(), record.GetPlayTime()));
+            return send(MakeStringResponse(http::status::ok, *page_, req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv));
         }
 
-        sort(vec.begin(), vec.end(), [](const std::tuple<std::string, size_t, int64_t> &a, const std::tuple<std::string, size_t, int64_t> &b)
-             { return (get<1>(a) < get<1>(b)); });
+        // Запрос к базе не занимает поток io_context: ответ отправится, когда пул выдаст соединение и страница будет прочитана
+        db_->GetPlayerRecords().AsyncGetRecordsTable(
+            start, limit, std::move(cursor_), std::move(executor),
+            [self = shared_from_this(), send = std::move(send), version = req.version(), keep_alive = req.keep_alive()](boost::system::error_code ec, std::vector<database::PlayerRecord> records)
+            {
+                if (ec)
+                {
+                    return send(self->MakeStringResponse(http::status::service_unavailable, self->Error("Service Unavailable", "Records are temporarily unavailable"), version, keep_alive, ContentType::TEXT_JSON, "no-cache"sv));
+                }
+                send(self->MakeStringResponse(http::status::ok, RecordsJson(records), version, keep_alive, ContentType::TEXT_JSON, "no-cache"sv));
+            });
+    }
 
-        json::array obj{limit};
+    std::string ResponseApi::RecordsJson(std::span<const database::PlayerRecord> records)
+    {
+        json::array obj;
+        obj.reserve(records.size());
 
-        for (const auto &item : vec)
+        for (const auto &record : records)
         {
             json::object record_obj =
                 {
-                    {kName, get<0>(item)},
-                    {kScore, get<1>(item)},
-                    {"playTime", get<2>(item)}};
+                    {kName, record.GetName()},
+                    {kScore, record.GetScore()},
+                    {"playTime", record.GetPlayTime()}};
 
             obj.push_back(record_obj);
         }
 
-        return MakeStringResponse(http::status::ok, json::serialize(obj), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+        return json::serialize(obj);
+    }
+
+    ResponseApi::StringResponse ResponseApi::Metrics(const StringRequest &req)
+    {
+        if (req.method() != boost::beast::http::verb::get && req.method() != boost::beast::http::verb::head)
+        {
+            return MakeStringResponse(http::status::method_not_allowed, Error("Invalid Method", "Only GET and HEAD methods are expected"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv, "GET, HEAD"sv);
+        }
+
+        json::array sessions_array_;
+        size_t live_loot_total_ = 0;
+
+        for (const auto &session : game_.GetGameSessions())
+        {
+            const size_t live_loot_ = session->GetMapState().GetLoots().Size();
+            live_loot_total_ += live_loot_;
+
+            json::object obj =
+                {
+                    {kId, *session->GetId()},
+                    {"mapId", *session->GetMap().GetId()},
+                    {kPlayers, session->GetDogs().size()},
+                    {"liveLoot", live_loot_},
+                    {"spawnedLoot", session->GetMapState().GetSpawnedCount()},
+                    {"maxLoot", session->GetMap().GetMaxLoot()},
+                };
+
+            sessions_array_.push_back(obj);
+        }
+
+        const auto &tick_stats_ = application_.GetTickStats();
+        json::object tick_obj_ =
+            {
+                {"ticks", tick_stats_.ticks.load()},
+                {"steps", tick_stats_.steps.load()},
+                {"skippedSteps", tick_stats_.skipped_steps.load()},
+                {"overruns", tick_stats_.overruns.load()},
+                {"lastTickUs", tick_stats_.last_tick_us.load()},
+                {"maxTickUs", tick_stats_.max_tick_us.load()},
+                {"maxTickStep", game_.GetMaxTickStep().count()},
+            };
+
+        json::object metrics_obj_ =
+            {
+                {"sessions", sessions_array_},
+                {"liveLootTotal", live_loot_total_},
+                {"tick", tick_obj_},
+            };
+
+        if (const auto db = game_.GetDB())
+        {
+            const auto records_stats_ = db->GetRecordWriter().GetStats();
+            metrics_obj_["records"] = {
+                {"enqueued", records_stats_.enqueued},
+                {"written", records_stats_.written},
+                {"dropped", records_stats_.dropped},
+                {"failed", records_stats_.failed},
+                {"batches", records_stats_.batches},
+                {"depth", records_stats_.depth},
+                {"maxDepth", records_stats_.max_depth},
+                {"capacity", records_stats_.capacity},
+            };
+
+            const auto pool_stats_ = db->GetPoolStats();
+            metrics_obj_["databasePool"] = {
+                {"capacity", pool_stats_.capacity},
+                {"inUse", pool_stats_.in_use},
+                {"utilization", pool_stats_.capacity == 0 ? 0.0 : static_cast<double>(pool_stats_.in_use) / static_cast<double>(pool_stats_.capacity)},
+                {"waiting", pool_stats_.waiting},
+                {"acquired", pool_stats_.acquired},
+                {"timeouts", pool_stats_.timeouts},
+                {"reconnects", pool_stats_.reconnects},
+                {"reconnectFailures", pool_stats_.reconnect_failures},
+                {"avgWaitUs", pool_stats_.acquired == 0 ? 0.0 : static_cast<double>(pool_stats_.total_wait_us) / static_cast<double>(pool_stats_.acquired)},
+                {"maxWaitUs", pool_stats_.max_wait_us},
+            };
+
+            const auto leaderboard_stats_ = db->GetLeaderboard().GetStats();
+            const uint64_t lookups_ = leaderboard_stats_.hits + leaderboard_stats_.misses + leaderboard_stats_.fallbacks;
+            metrics_obj_["leaderboard"] = {
+                {"hits", leaderboard_stats_.hits},
+                {"misses", leaderboard_stats_.misses},
+                {"fallbacks", leaderboard_stats_.fallbacks},
+                {"hitRate", lookups_ == 0 ? 0.0 : static_cast<double>(leaderboard_stats_.hits) / static_cast<double>(lookups_)},
+                {"size", leaderboard_stats_.size},
+                {"capacity", leaderboard_stats_.capacity},
+                {"version", leaderboard_stats_.version},
+            };
+        }
+
+        const auto state_stats_ = state_cache_.GetStats();
+        metrics_obj_["stateCache"] = {
+            {"hits", state_stats_.hits},
+            {"misses", state_stats_.misses},
+        };
+
+        return MakeStringResponse(http::status::ok, json::serialize(metrics_obj_), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+    }
+
+    boost::json::object ResponseApi::ProfileObject(const model::TickProfile &profile)
+    {
+        static const std::array<std::string_view, static_cast<size_t>(model::TickPhase::COUNT)> phase_names =
+            {"lootGeneration"sv, "movement"sv, "retirement"sv, "collision"sv, "saveState"sv, "tick"sv};
+        constexpr double kNanosecondsToMicroseconds = 1000.0;
+
+        json::object phases_obj_;
+        for (size_t i = 0; i < profile.size(); ++i)
+        {
+            const auto &histogram = profile[i];
+            if (histogram.GetCount() == 0)
+                continue;
+
+            phases_obj_[phase_names[i]] = {
+                {"count", histogram.GetCount()},
+                {"p50Us", histogram.GetPercentile(0.5) / kNanosecondsToMicroseconds},
+                {"p99Us", histogram.GetPercentile(0.99) / kNanosecondsToMicroseconds},
+                {"maxUs", histogram.GetMax() / kNanosecondsToMicroseconds},
+            };
+        }
+        return phases_obj_;
+    }
+
+    ResponseApi::StringResponse ResponseApi::Profile(const StringRequest &req)
+    {
+        if (req.method() == boost::beast::http::verb::post)
+        {
+            try
+            {
+                const auto value = json::parse(req.body()).as_object();
+                if (const auto *enabled = value.if_contains("enabled"))
+                {
+                    game_.SetProfiling(enabled->as_bool());
+                }
+                if (const auto *reset = value.if_contains("reset"); reset != nullptr && reset->as_bool())
+                {
+                    game_.ResetProfile();
+                }
+            }
+            catch (...)
+            {
+                return MakeStringResponse(http::status::bad_request, Error("Invalid Argument", "Profile request parse error"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+            }
+        }
+        else if (req.method() != boost::beast::http::verb::get && req.method() != boost::beast::http::verb::head)
+        {
+            return MakeStringResponse(http::status::method_not_allowed, Error("Invalid Method", "Only GET, HEAD and POST methods are expected"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv, "GET, HEAD, POST"sv);
+        }
+
+        // Сводка по фазам всех сессий складывается из их гистограмм при запросе
+        auto total_ = std::make_unique<model::TickProfile>();
+        for (size_t i = 0; i < total_->size(); ++i)
+        {
+            (*total_)[i].Merge(game_.GetProfile()[i]);
+        }
+
+        json::array sessions_array_;
+        for (const auto &session : game_.GetGameSessions())
+        {
+            for (size_t i = 0; i < total_->size(); ++i)
+            {
+                (*total_)[i].Merge(session->GetProfile()[i]);
+            }
+
+            sessions_array_.push_back(json::object{
+                {kId, *session->GetId()},
+                {"phases", ProfileObject(session->GetProfile())},
+            });
+        }
+
+        json::object profile_obj_ =
+            {
+                {"enabled", game_.IsProfiling()},
+                {"phases", ProfileObject(*total_)},
+                {"sessions", sessions_array_},
+            };
+
+        return MakeStringResponse(http::status::ok, json::serialize(profile_obj_), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+    }
+
+    void ResponseApi::RequestAsync(const StringRequest &req, std::string path, net::any_io_executor executor, Sender send)
+    {
+        // Рекорды могут потребовать запроса к базе, поэтому ответ на них отправляется асинхронно
+        if (std::strstr(path.data(), "api/v1/game/records"))
+        {
+            return Records(req, std::move(executor), std::move(send));
+        }
+
+        // Состояние отдаётся готовым общим телом, а не через StringResponse
+        if (std::strstr(path.data(), "api/v1/game/state"))
+        {
+            return send(State(req));
+        }
+
+        send(Request(req, std::move(path)));
     }
 
     ResponseApi::StringResponse ResponseApi::Request(const StringRequest &req, std::string path)
@@ -602,6 +970,26 @@ namespace http_handler
 
             return (MakeStringResponse(http::status::ok, body, req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv, "GET, HEAD"sv));
         }
+        else if (std::strstr(path.data(), "api/v1/admin"))
+        {
+            // Служебные маршруты, как и ручной тик, доступны только в отладочном режиме
+            if (!game_.IsDebug())
+            {
+                return MakeStringResponse(http::status::not_found, Error("Not Found", "Admin API is disabled"), req.version(), req.keep_alive(), ContentType::TEXT_JSON, "no-cache"sv);
+            }
+
+            std::string target = path.substr(path.find_last_of('/') + 1, path.size()).data();
+
+            if (target == "metrics")
+            {
+                return Metrics(std::move(req));
+            }
+
+            if (target == "profile")
+            {
+                return Profile(std::move(req));
+            }
+        }
         else if (std::strstr(path.data(), "api/v1/game"))
         {
             std::string target = path.substr(path.find_last_of('/') + 1, path.size()).data();
@@ -616,21 +1004,11 @@ namespace http_handler
                 return Player(std::move(req));
             }
 
-            if (target == "state")
-            {
-                return State(std::move(req));
-            }
-
             if (target == "action")
             {
                 return PlayerAction(std::move(req));
             }
 
-            if (target == "records")
-            {
-                return Records(std::move(req));
-            }
-
             if (target == "tick" && game_.IsDebug())
             {
                 return Tick(std::move(req));
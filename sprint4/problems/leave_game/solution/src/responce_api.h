@@ -5,46 +5,68 @@
 #include "model.h"
 #include "player.h"
 #include "application.h"
+#include "shared_body.h"
+#include "state_cache.h"
 
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/json.hpp>
 
+#include <variant>
+
 namespace http_handler
 {
     namespace beast = boost::beast;
     namespace http = beast::http;
     namespace json = boost::json;
 
-    class ResponseApi
+    namespace net = boost::asio;
+
+    class ResponseApi : public std::enable_shared_from_this<ResponseApi>
     {
 
         using StringResponse = http::response<http::string_body>;
         using StringRequest = http::request<http::string_body>;
+        // Ответ с общим неизменяемым телом, отправляется без копирования
+        using SharedResponse = http::response<SharedStringBody>;
+        using ApiResponse = std::variant<StringResponse, SharedResponse>;
+        using Sender = std::function<void(ApiResponse)>;
 
     public:
         ResponseApi(model::Game &game,
                     app::Players &players,
                     add_data::GameLoots &game_loots,
-                    app::Application &application)
+                    app::Application &application,
+                    StateCache &state_cache)
             : game_{game},
               players_{players},
               game_loots_{game_loots},
-              application_{application} {
+              application_{application},
+              state_cache_{state_cache} {
 
               };
 
         StringResponse Request(const StringRequest &req, std::string path);
 
+        // Как Request, но ответ передаётся в send; запросы к базе не блокируют поток executor
+        void RequestAsync(const StringRequest &req, std::string path, net::any_io_executor executor, Sender send);
+
+        // Тело ответа /state; им же заполняются кадры WebSocket-подписки
+        static std::string StateJson(const model::SessionSnapshot &snapshot, const app::PlayerDirectory &directory);
+
     private:
         model::Game &game_;
         app::Players &players_;
         add_data::GameLoots &game_loots_;
         app::Application &application_;
+        StateCache &state_cache_;
 
+        std::optional<std::string> ExtractToken(const StringRequest &req, StringResponse &res);
         std::shared_ptr<app::Player> Authorization(const StringRequest &req,
                                                    StringResponse &&res);
+        // Авторизация по опубликованному справочнику игроков, без обращения к Players
+        const app::PlayerEntry *AuthorizeSnapshot(const StringRequest &req, const app::PlayerDirectory &directory, StringResponse &res);
 
         // возвращает Json с ошибкой
         std::string Error(std::string code, std::string msg);
@@ -57,9 +79,23 @@ namespace http_handler
         StringResponse Tick(const StringRequest &req);
         StringResponse JoinGame(const StringRequest &req);
         StringResponse Player(const StringRequest &req);
-        StringResponse Records(const StringRequest &req);
-        StringResponse State(const StringRequest &req);
+        // Рекорды отдаются из таблицы в памяти с кешем готовых страниц
+        void Records(const StringRequest &req, net::any_io_executor executor, Sender send);
+        static std::string RecordsJson(std::span<const database::PlayerRecord> records);
+        // Состояние сессии из кеша сериализованных снимков; If-None-Match с текущим ETag даёт 304.
+        // С параметром since=<тик> - только изменения после этого тика (или полный снимок, если история короче)
+        ApiResponse State(const StringRequest &req);
+        static std::string StateDeltaJson(const model::SessionSnapshot &snapshot, const app::PlayerDirectory &directory, uint64_t since);
+        // complete сбрасывается, если у какой-то собаки ещё нет игрока в справочнике
+        static boost::json::object StateObject(const model::SessionSnapshot &snapshot, const app::PlayerDirectory &directory, bool &complete);
+        static boost::json::object DogStateObject(const model::DogSnapshot &dog);
+        static boost::json::object LootStateObject(const model::MapLoot &loot);
         StringResponse PlayerAction(const StringRequest &req);
+        // Служебные метрики: игроки и трофеи каждой сессии
+        StringResponse Metrics(const StringRequest &req);
+        // Профиль фаз тика: GET - квантили по игре и сессиям, POST {"enabled", "reset"} - управление
+        StringResponse Profile(const StringRequest &req);
+        boost::json::object ProfileObject(const model::TickProfile &profile);
         boost::json::array RoadsObject(const model::Map &data_map);
         boost::json::array BuildingsObject(const model::Map &data_map);
         boost::json::array OfficesObject(const model::Map &data_map);
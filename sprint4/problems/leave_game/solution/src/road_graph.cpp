@@ -0,0 +1,264 @@
+#include "road_graph.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <queue>
+#include <utility>
+
+namespace model
+{
+    namespace
+    {
+        using Interval = std::pair<int, int>;
+        using Lines = std::map<int, std::vector<Interval>>;
+
+        // Сливает перекрывающиеся и касающиеся отрезки одной прямой
+        void MergeIntervals(std::vector<Interval> &intervals)
+        {
+            std::sort(intervals.begin(), intervals.end());
+
+            std::vector<Interval> merged;
+            for (const auto &interval : intervals)
+            {
+                if (!merged.empty() && interval.first <= merged.back().second)
+                {
+                    merged.back().second = std::max(merged.back().second, interval.second);
+                }
+                else
+                {
+                    merged.push_back(interval);
+                }
+            }
+            intervals = std::move(merged);
+        }
+
+        // Индекс слитого отрезка, содержащего coord, или -1
+        int FindInterval(const std::vector<Interval> &intervals, int coord)
+        {
+            auto it = std::upper_bound(intervals.begin(), intervals.end(), coord,
+                                       [](int value, const Interval &interval)
+                                       { return value < interval.first; });
+            if (it == intervals.begin())
+            {
+                return -1;
+            }
+            --it;
+            return coord <= it->second ? static_cast<int>(it - intervals.begin()) : -1;
+        }
+    } // namespace
+
+    void RoadGraph::AddRoad(int x0, int y0, int x1, int y1)
+    {
+        if (y0 == y1)
+        {
+            roads_.push_back({true, y0, std::min(x0, x1), std::max(x0, x1)});
+        }
+        else
+        {
+            roads_.push_back({false, x0, std::min(y0, y1), std::max(y0, y1)});
+        }
+        built_ = false;
+    }
+
+    RoadGraph::Index RoadGraph::AddNode(int x, int y)
+    {
+        auto [it, inserted] = node_by_point_.emplace(MakeKey(x, y), static_cast<Index>(nodes_.size()));
+        if (inserted)
+        {
+            nodes_.push_back(Node{x, y});
+        }
+        return it->second;
+    }
+
+    void RoadGraph::Build()
+    {
+        segments_.clear();
+        nodes_.clear();
+        node_by_point_.clear();
+        road_to_segment_.assign(roads_.size(), kNone);
+
+        Lines horizontal;
+        Lines vertical;
+        for (const auto &road : roads_)
+        {
+            (road.horizontal ? horizontal : vertical)[road.line].emplace_back(road.from, road.to);
+        }
+
+        // Первый отрезок каждой прямой; отрезки одной прямой идут подряд
+        std::map<int, Index> first_horizontal;
+        std::map<int, Index> first_vertical;
+        auto add_segments = [this](Lines &lines, std::map<int, Index> &first, bool is_horizontal)
+        {
+            for (auto &[line, intervals] : lines)
+            {
+                MergeIntervals(intervals);
+                first[line] = static_cast<Index>(segments_.size());
+                for (const auto &[from, to] : intervals)
+                {
+                    segments_.push_back(Segment{is_horizontal, line, from, to, {}});
+                }
+            }
+        };
+        add_segments(horizontal, first_horizontal, true);
+        add_segments(vertical, first_vertical, false);
+
+        for (std::size_t i = 0; i < roads_.size(); ++i)
+        {
+            const auto &road = roads_[i];
+            const auto &lines = road.horizontal ? horizontal : vertical;
+            const auto &first = road.horizontal ? first_horizontal : first_vertical;
+            road_to_segment_[i] = first.at(road.line) + FindInterval(lines.at(road.line), road.from);
+        }
+
+        // Концы отрезков
+        for (Index s = 0; s < segments_.size(); ++s)
+        {
+            const auto &segment = segments_[s];
+            for (int coord : {segment.from, segment.to})
+            {
+                const Index node = segment.horizontal ? AddNode(coord, segment.line) : AddNode(segment.line, coord);
+                (segment.horizontal ? nodes_[node].horizontal : nodes_[node].vertical) = s;
+            }
+        }
+
+        // Пересечения: для каждого вертикального отрезка перебираются горизонтальные прямые в его пределах
+        for (const auto &[x, first_segment] : first_vertical)
+        {
+            const auto &intervals = vertical.at(x);
+            for (std::size_t v = 0; v < intervals.size(); ++v)
+            {
+                const Index vertical_segment = first_segment + static_cast<Index>(v);
+                for (auto it = horizontal.lower_bound(intervals[v].first);
+                     it != horizontal.end() && it->first <= intervals[v].second; ++it)
+                {
+                    const int h = FindInterval(it->second, x);
+                    if (h < 0)
+                    {
+                        continue;
+                    }
+                    const Index node = AddNode(x, it->first);
+                    nodes_[node].horizontal = first_horizontal.at(it->first) + h;
+                    nodes_[node].vertical = vertical_segment;
+                }
+            }
+        }
+
+        // Узлы отрезков по порядку и соседи вдоль них
+        for (Index n = 0; n < nodes_.size(); ++n)
+        {
+            if (nodes_[n].horizontal != kNone)
+            {
+                segments_[nodes_[n].horizontal].nodes.push_back(n);
+            }
+            if (nodes_[n].vertical != kNone)
+            {
+                segments_[nodes_[n].vertical].nodes.push_back(n);
+            }
+        }
+        for (auto &segment : segments_)
+        {
+            const bool is_horizontal = segment.horizontal;
+            std::sort(segment.nodes.begin(), segment.nodes.end(),
+                      [this, is_horizontal](Index lhs, Index rhs)
+                      {
+                          return is_horizontal ? nodes_[lhs].x < nodes_[rhs].x
+                                               : nodes_[lhs].y < nodes_[rhs].y;
+                      });
+
+            const Side backward = is_horizontal ? kWest : kNorth;
+            const Side forward = is_horizontal ? kEast : kSouth;
+            for (std::size_t i = 1; i < segment.nodes.size(); ++i)
+            {
+                nodes_[segment.nodes[i]].neighbours[backward] = segment.nodes[i - 1];
+                nodes_[segment.nodes[i - 1]].neighbours[forward] = segment.nodes[i];
+            }
+        }
+
+        built_ = true;
+    }
+
+    RoadGraph::Index RoadGraph::FindNodeOnSegment(Index segment, int coord) const noexcept
+    {
+        const auto &road = segments_[segment];
+        auto it = std::lower_bound(road.nodes.begin(), road.nodes.end(), coord,
+                                   [this, &road](Index node, int value)
+                                   {
+                                       return (road.horizontal ? nodes_[node].x : nodes_[node].y) < value;
+                                   });
+        if (it == road.nodes.end())
+        {
+            return kNone;
+        }
+        return (road.horizontal ? nodes_[*it].x : nodes_[*it].y) == coord ? *it : kNone;
+    }
+
+    RoadGraph::Index RoadGraph::FindNode(int x, int y) const noexcept
+    {
+        auto it = node_by_point_.find(MakeKey(x, y));
+        return it == node_by_point_.end() ? kNone : it->second;
+    }
+
+    RoadGraph::Route RoadGraph::FindRoute(Index from, Index to) const
+    {
+        Route route;
+        if (from >= nodes_.size() || to >= nodes_.size())
+        {
+            return route;
+        }
+
+        constexpr int64_t kInfinity = std::numeric_limits<int64_t>::max();
+        std::vector<int64_t> distance(nodes_.size(), kInfinity);
+        std::vector<Index> previous(nodes_.size(), kNone);
+
+        using Entry = std::pair<int64_t, Index>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+        distance[from] = 0;
+        queue.emplace(0, from);
+
+        while (!queue.empty())
+        {
+            const auto [length, node] = queue.top();
+            queue.pop();
+            if (length != distance[node])
+            {
+                continue;
+            }
+            if (node == to)
+            {
+                break;
+            }
+
+            for (Index next : nodes_[node].neighbours)
+            {
+                if (next == kNone)
+                {
+                    continue;
+                }
+                const int64_t step = std::abs(static_cast<int64_t>(nodes_[next].x) - nodes_[node].x) +
+                                     std::abs(static_cast<int64_t>(nodes_[next].y) - nodes_[node].y);
+                if (length + step < distance[next])
+                {
+                    distance[next] = length + step;
+                    previous[next] = node;
+                    queue.emplace(distance[next], next);
+                }
+            }
+        }
+
+        if (distance[to] == kInfinity)
+        {
+            return route;
+        }
+
+        for (Index node = to; node != kNone; node = previous[node])
+        {
+            route.nodes.push_back(node);
+        }
+        std::reverse(route.nodes.begin(), route.nodes.end());
+        route.length = distance[to];
+        return route;
+    }
+
+} // namespace model
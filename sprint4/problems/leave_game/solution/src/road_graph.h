@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace model
+{
+    /*
+     *  Дорожная сеть карты, собранная при загрузке.
+     *  Дороги одной прямой, которые перекрываются или касаются, сливаются в один отрезок,
+     *  концы отрезков и пересечения становятся узлами, у каждого узла есть соседи по четырём направлениям.
+     */
+    class RoadGraph
+    {
+    public:
+        using Index = uint32_t;
+        static constexpr Index kNone = std::numeric_limits<Index>::max();
+
+        // Порядок совпадает с соседями узла
+        enum Side : uint8_t
+        {
+            kWest = 0,
+            kEast = 1,
+            kNorth = 2,
+            kSouth = 3,
+        };
+
+        struct Segment
+        {
+            bool horizontal;
+            // y для горизонтального отрезка, x для вертикального
+            int line;
+            // Границы вдоль отрезка, from <= to
+            int from;
+            int to;
+            // Узлы отрезка по возрастанию координаты вдоль него
+            std::vector<Index> nodes;
+        };
+
+        struct Node
+        {
+            int x;
+            int y;
+            std::array<Index, 4> neighbours{kNone, kNone, kNone, kNone};
+            Index horizontal = kNone;
+            Index vertical = kNone;
+        };
+
+        struct Route
+        {
+            std::vector<Index> nodes;
+            int64_t length = 0;
+        };
+
+        // Дорога карты в порядке загрузки
+        void AddRoad(int x0, int y0, int x1, int y1);
+
+        // Собирает граф из добавленных дорог
+        void Build();
+
+        bool IsBuilt() const noexcept
+        {
+            return built_;
+        }
+
+        std::size_t SegmentsCount() const noexcept
+        {
+            return segments_.size();
+        }
+
+        std::size_t NodesCount() const noexcept
+        {
+            return nodes_.size();
+        }
+
+        const Segment &GetSegment(Index segment) const noexcept
+        {
+            return segments_[segment];
+        }
+
+        const Node &GetNode(Index node) const noexcept
+        {
+            return nodes_[node];
+        }
+
+        // Отрезок, в который вошла дорога с индексом road
+        Index SegmentOfRoad(std::size_t road) const noexcept
+        {
+            return road < road_to_segment_.size() ? road_to_segment_[road] : kNone;
+        }
+
+        // Узел отрезка с координатой coord вдоль него или kNone
+        Index FindNodeOnSegment(Index segment, int coord) const noexcept;
+
+        Index FindNode(int x, int y) const noexcept;
+
+        // Кратчайший путь по дорогам между узлами; пустой, если пути нет
+        Route FindRoute(Index from, Index to) const;
+
+    private:
+        struct RawRoad
+        {
+            bool horizontal;
+            int line;
+            int from;
+            int to;
+        };
+
+        static uint64_t MakeKey(int x, int y) noexcept
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        }
+
+        Index AddNode(int x, int y);
+
+        std::vector<RawRoad> roads_;
+        std::vector<Index> road_to_segment_;
+        std::vector<Segment> segments_;
+        std::vector<Node> nodes_;
+        std::unordered_map<uint64_t, Index> node_by_point_;
+        bool built_ = false;
+    };
+
+} // namespace model
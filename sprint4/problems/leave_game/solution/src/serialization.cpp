@@ -32,7 +32,7 @@ namespace serialization
     {
         std::vector<MapLootSerialization> map_loot_ser;
 
-        for (auto &loot : game_session.GetMap().GetLoots())
+        for (auto &loot : game_session.GetMapState().GetLoots())
         {
             map_loot_ser.push_back(std::move(MapLootSerialization(loot)));
         };
@@ -52,22 +52,27 @@ namespace serialization
         return dog_ser;
     };
 
-    model::GameSession GameSessionSerialization::Restore(const model::Game &game) const
+    std::shared_ptr<model::GameSession> GameSessionSerialization::Restore(const model::Game &game) const
     {
         auto map_ = game.FindMap(util::Tagged<std::string, model::Map>(map_name_));
+        auto game_session_ = std::make_shared<model::GameSession>(util::Tagged<std::string, model::GameSession>(id_), std::move(map_));
 
         for (auto &loot : loots_)
         {
-            map_->AddLoot(loot.Restore());
+            game_session_->GetMapState().AddLoot(loot.Restore());
         }
 
-        model::GameSession game_session_(util::Tagged<std::string, model::GameSession>(id_), std::move(*map_));
-        game_session_.SetMaxNumLoot(num_loot_);
+        game_session_->SetMaxNumLoot(num_loot_);
+
+        if (has_random_state_)
+        {
+            game_session_->GetRandom().SetState(random_state_);
+        }
 
         for (auto &dog : dogs_)
         {
             auto shared = std::make_shared<model::Dog>(dog.Restore());
-            game_session_.AddDog(shared);
+            game_session_->AddDog(shared);
         }
 
         return game_session_;
@@ -102,15 +107,24 @@ namespace serialization
     {
         for (auto &game_session_ : game_sessions_)
         {
-            auto session_restore = game_session_.Restore(new_game_);
-            auto shared = std::make_shared<model::GameSession>(session_restore);
+            auto shared = game_session_.Restore(new_game_);
             new_game_.AddGameSession(shared);
         }
 
         for (auto &player_ : players_)
         {
-            new_players_.AddPlayer(std::make_shared<app::Player>(player_.Restore()));
+            auto player = std::make_shared<app::Player>(player_.Restore());
+
+            // Ссылки на собак не сохраняются: после загрузки они строятся заново по именам
+            if (auto session = new_game_.FindGameSession(player->GetGameSessionId()); session != nullptr)
+            {
+                if (auto dog = session->FindDog(player->GetDogId()); dog != nullptr)
+                    player->SetDogHandle(session->GetHandle(*dog));
+            }
+
+            new_players_.AddPlayer(std::move(player));
         }
+        new_players_.PublishDirectory();
     }
 
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/fiber/future/promise.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/array.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "model.h"
 #include "player.h"
@@ -130,7 +132,8 @@ namespace serialization
 
         GameSessionSerialization(const model::GameSession &game_session) : id_(*game_session.GetId()),
                                                                            map_name_(*game_session.GetMap().GetId()),
-                                                                           num_loot_(game_session.GetMaxNumLoot())
+                                                                           num_loot_(game_session.GetMaxNumLoot()),
+                                                                           random_state_(game_session.GetRandom().GetState())
         {
             dogs_ = GetDogSerializedData(game_session);
             loots_ = GetMapLootSerializedData(game_session);
@@ -141,20 +144,29 @@ namespace serialization
 
         std::vector<DogSerialization> GetDogSerializedData(const model::GameSession &game_session);
 
-        model::GameSession Restore(const model::Game &game) const;
+        std::shared_ptr<model::GameSession> Restore(const model::Game &game) const;
 
         template <class Archive>
-        void serialize(Archive &ar, [[maybe_unused]] const unsigned int version)
+        void serialize(Archive &ar, const unsigned int version)
         {
             ar & id_;
             ar & dogs_;
             ar & map_name_;
             ar & num_loot_;
             ar & loots_;
+
+            // Состояние генератора сохраняется начиная с версии 1
+            if (version >= 1)
+            {
+                ar & random_state_;
+                has_random_state_ = true;
+            }
         }
 
     private:
         size_t num_loot_{0};
+        util::RandomEngine::State random_state_{};
+        bool has_random_state_ = false;
         std::string id_;
         std::string map_name_;
         std::vector<DogSerialization> dogs_;
@@ -195,4 +207,6 @@ namespace serialization
         std::vector<PlayerSerialization> players_;
     };
 
-}
\ No newline at end of file
+}
+
+BOOST_CLASS_VERSION(::serialization::GameSessionSerialization, 1)
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "grow_only_slots.h"
+
+#include <boost/asio.hpp>
+
+#include <cstdint>
+
+namespace http_handler
+{
+    namespace net = boost::asio;
+
+    /*
+     *  Strand на каждую игровую сессию. Запросы к одной сессии выполняются последовательно,
+     *  к разным - параллельно на потоках io_context. Strand создаётся при первом обращении к сессии.
+     */
+    class SessionStrands
+    {
+    public:
+        using Strand = net::strand<net::io_context::executor_type>;
+
+        explicit SessionStrands(net::io_context::executor_type executor)
+            : executor_{executor}
+        {
+        }
+
+        SessionStrands(const SessionStrands &) = delete;
+        SessionStrands &operator=(const SessionStrands &) = delete;
+
+        Strand Get(uint32_t session_index)
+        {
+            // Strand, построенный из executor, получает собственную очередь
+            return strands_.Get(session_index, executor_);
+        }
+
+    private:
+        net::io_context::executor_type executor_;
+        util::GrowOnlySlots<Strand> strands_;
+    };
+
+} // namespace http_handler
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace util
+{
+    /*
+     *  Контейнер с устойчивыми ключами: значения лежат в непрерывном массиве,
+     *  ключ ссылается на слот, а слот - на позицию значения в массиве.
+     *  Поиск и удаление за O(1), при удалении на место значения переносится последнее.
+     *  Ключ содержит номер поколения слота, поэтому ключ удалённого значения не совпадёт с ключом нового.
+     *  Старший бит ключа всегда нулевой, так что ключ можно хранить в int.
+     */
+    template <typename T>
+    class SlotMap
+    {
+    public:
+        using Key = uint32_t;
+        using Values = std::vector<T>;
+        using iterator = typename Values::iterator;
+        using const_iterator = typename Values::const_iterator;
+
+        static constexpr uint32_t kIndexBits = 20;
+        static constexpr uint32_t kGenerationBits = 11;
+        static constexpr size_t kMaxSize = size_t{1} << kIndexBits;
+
+        // Добавляет значение и возвращает его ключ
+        Key Insert(T value)
+        {
+            uint32_t slot_index;
+
+            if (!free_slots_.empty())
+            {
+                slot_index = free_slots_.back();
+            }
+            else
+            {
+                if (slots_.size() >= kMaxSize)
+                    throw std::length_error("SlotMap is full");
+
+                slot_index = static_cast<uint32_t>(slots_.size());
+                slots_.push_back({});
+            }
+
+            Slot &slot = slots_[slot_index];
+            values_.push_back(std::move(value));
+            try
+            {
+                dense_to_slot_.push_back(slot_index);
+            }
+            catch (...)
+            {
+                values_.pop_back();
+                throw;
+            }
+
+            if (!free_slots_.empty() && free_slots_.back() == slot_index)
+                free_slots_.pop_back();
+
+            slot.dense_index = static_cast<uint32_t>(values_.size() - 1);
+            slot.occupied = true;
+            return MakeKey(slot_index, slot.generation);
+        }
+
+        T *Find(Key key) noexcept
+        {
+            const Slot *slot = FindSlot(key);
+            return slot == nullptr ? nullptr : &values_[slot->dense_index];
+        }
+
+        const T *Find(Key key) const noexcept
+        {
+            const Slot *slot = FindSlot(key);
+            return slot == nullptr ? nullptr : &values_[slot->dense_index];
+        }
+
+        bool Contains(Key key) const noexcept
+        {
+            return FindSlot(key) != nullptr;
+        }
+
+        // Удаляет значение по ключу. Возвращает false, если ключ устарел или не существовал
+        bool Erase(Key key)
+        {
+            const Slot *found = FindSlot(key);
+            if (found == nullptr)
+                return false;
+
+            const uint32_t slot_index = KeyIndex(key);
+            Slot &slot = slots_[slot_index];
+            const uint32_t dense_index = slot.dense_index;
+            const uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+
+            if (dense_index != last)
+            {
+                values_[dense_index] = std::move(values_[last]);
+                dense_to_slot_[dense_index] = dense_to_slot_[last];
+                slots_[dense_to_slot_[dense_index]].dense_index = dense_index;
+            }
+
+            values_.pop_back();
+            dense_to_slot_.pop_back();
+
+            slot.occupied = false;
+            slot.generation = (slot.generation + 1) & kGenerationMask;
+            free_slots_.push_back(slot_index);
+            return true;
+        }
+
+        // Ключ значения, лежащего на позиции index непрерывного массива
+        Key KeyAt(size_t index) const noexcept
+        {
+            const uint32_t slot_index = dense_to_slot_[index];
+            return MakeKey(slot_index, slots_[slot_index].generation);
+        }
+
+        std::span<const T> GetValues() const noexcept
+        {
+            return values_;
+        }
+
+        size_t Size() const noexcept
+        {
+            return values_.size();
+        }
+
+        bool Empty() const noexcept
+        {
+            return values_.empty();
+        }
+
+        void Reserve(size_t count)
+        {
+            values_.reserve(count);
+            dense_to_slot_.reserve(count);
+            slots_.reserve(count);
+        }
+
+        void Clear() noexcept
+        {
+            for (uint32_t slot_index : dense_to_slot_)
+            {
+                Slot &slot = slots_[slot_index];
+                slot.occupied = false;
+                slot.generation = (slot.generation + 1) & kGenerationMask;
+                free_slots_.push_back(slot_index);
+            }
+
+            values_.clear();
+            dense_to_slot_.clear();
+        }
+
+        iterator begin() noexcept { return values_.begin(); }
+        iterator end() noexcept { return values_.end(); }
+        const_iterator begin() const noexcept { return values_.begin(); }
+        const_iterator end() const noexcept { return values_.end(); }
+
+    private:
+        static constexpr uint32_t kIndexMask = (uint32_t{1} << kIndexBits) - 1;
+        static constexpr uint32_t kGenerationMask = (uint32_t{1} << kGenerationBits) - 1;
+
+        struct Slot
+        {
+            uint32_t dense_index = 0;
+            uint32_t generation = 0;
+            bool occupied = false;
+        };
+
+        static Key MakeKey(uint32_t slot_index, uint32_t generation) noexcept
+        {
+            return (generation << kIndexBits) | slot_index;
+        }
+
+        static uint32_t KeyIndex(Key key) noexcept
+        {
+            return key & kIndexMask;
+        }
+
+        const Slot *FindSlot(Key key) const noexcept
+        {
+            const uint32_t slot_index = KeyIndex(key);
+            if (slot_index >= slots_.size())
+                return nullptr;
+
+            const Slot &slot = slots_[slot_index];
+            if (!slot.occupied || MakeKey(slot_index, slot.generation) != key)
+                return nullptr;
+
+            return &slot;
+        }
+
+        Values values_;
+        std::vector<uint32_t> dense_to_slot_;
+        std::vector<Slot> slots_;
+        std::vector<uint32_t> free_slots_;
+    };
+
+} // namespace util
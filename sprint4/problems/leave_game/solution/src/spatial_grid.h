@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace util
+{
+    /*
+     *  Равномерная сетка для быстрого поиска объектов по координатам.
+     *  Объект регистрируется во всех ячейках, которые пересекает его ограничивающий прямоугольник.
+     *  Внутри ячейки значения хранятся в порядке добавления.
+     */
+    template <typename Value>
+    class SpatialGrid
+    {
+    public:
+        using Cell = std::vector<Value>;
+
+        explicit SpatialGrid(double cell_size = 8.0) noexcept
+            : cell_size_{cell_size}
+        {
+        }
+
+        double GetCellSize() const noexcept
+        {
+            return cell_size_;
+        }
+
+        void Insert(double min_x, double min_y, double max_x, double max_y, const Value &value)
+        {
+            ForEachKey(min_x, min_y, max_x, max_y, [this, &value](Key key)
+                       { cells_[key].push_back(value); });
+        }
+
+        void Erase(double min_x, double min_y, double max_x, double max_y, const Value &value)
+        {
+            ForEachKey(min_x, min_y, max_x, max_y, [this, &value](Key key)
+                       {
+                           auto it = cells_.find(key);
+                           if (it == cells_.end())
+                               return;
+
+                           auto &cell = it->second;
+                           cell.erase(std::remove(cell.begin(), cell.end(), value), cell.end());
+
+                           if (cell.empty())
+                               cells_.erase(it); });
+        }
+
+        // Ячейка, в которую попадает точка, или nullptr, если в ней ничего нет
+        const Cell *FindCell(double x, double y) const noexcept
+        {
+            auto it = cells_.find(MakeKey(ToCell(x), ToCell(y)));
+            return it == cells_.end() ? nullptr : &it->second;
+        }
+
+        // Вызывает fn(const Cell &) для каждой непустой ячейки, пересекающей прямоугольник
+        template <typename Fn>
+        void ForEachCell(double min_x, double min_y, double max_x, double max_y, Fn &&fn) const
+        {
+            ForEachKey(min_x, min_y, max_x, max_y, [this, &fn](Key key)
+                       {
+                           if (auto it = cells_.find(key); it != cells_.end())
+                               fn(it->second); });
+        }
+
+        bool Empty() const noexcept
+        {
+            return cells_.empty();
+        }
+
+        void Clear() noexcept
+        {
+            cells_.clear();
+        }
+
+    private:
+        using Key = uint64_t;
+
+        int32_t ToCell(double coord) const noexcept
+        {
+            return static_cast<int32_t>(std::floor(coord / cell_size_));
+        }
+
+        static Key MakeKey(int32_t cell_x, int32_t cell_y) noexcept
+        {
+            return (static_cast<Key>(static_cast<uint32_t>(cell_x)) << 32) | static_cast<uint32_t>(cell_y);
+        }
+
+        template <typename Fn>
+        void ForEachKey(double min_x, double min_y, double max_x, double max_y, Fn &&fn) const
+        {
+            if (min_x > max_x)
+                std::swap(min_x, max_x);
+
+            if (min_y > max_y)
+                std::swap(min_y, max_y);
+
+            const int32_t last_x = ToCell(max_x);
+            const int32_t last_y = ToCell(max_y);
+
+            for (int32_t x = ToCell(min_x); x <= last_x; ++x)
+            {
+                for (int32_t y = ToCell(min_y); y <= last_y; ++y)
+                {
+                    fn(MakeKey(x, y));
+                }
+            }
+        }
+
+        double cell_size_;
+        std::unordered_map<Key, Cell> cells_;
+    };
+
+} // namespace util
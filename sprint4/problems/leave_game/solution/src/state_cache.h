@@ -0,0 +1,104 @@
+#pragma once
+
+#include "atomic_snapshot.h"
+#include "grow_only_slots.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace http_handler
+{
+    // Сериализованное состояние сессии для одного тика и версии её игроков в справочнике
+    struct CachedState
+    {
+        uint64_t tick = 0;
+        uint64_t session_version = 0;
+        std::string etag;
+        std::shared_ptr<const std::string> body;
+    };
+
+    struct StateCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    /*
+     *  Кеш ответов /state по сессиям. Тело строится первым запросом после публикации снимка,
+     *  остальные игроки сессии получают ту же строку, поэтому сериализаций не больше, чем тиков.
+     *  Вход и выход игроков других сессий ключ не меняют и кеш этой сессии не сбрасывают.
+     *  Одновременные промахи могут построить тело дважды - это дешевле блокировки на время сериализации.
+     */
+    class StateCache
+    {
+    public:
+        using Serializer = std::function<std::string()>;
+
+        StateCache() = default;
+        StateCache(const StateCache &) = delete;
+        StateCache &operator=(const StateCache &) = delete;
+
+        std::shared_ptr<const CachedState> Get(uint32_t session_index, uint64_t tick, uint64_t session_version, const Serializer &serialize)
+        {
+            auto &slot = slots_.Get(session_index);
+
+            if (auto cached = slot.Load(); cached && cached->tick == tick && cached->session_version == session_version)
+            {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return cached;
+            }
+
+            auto state = std::make_shared<CachedState>();
+            state->tick = tick;
+            state->session_version = session_version;
+            state->etag = MakeETag(session_index, tick, session_version);
+            state->body = std::make_shared<const std::string>(serialize());
+
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            slot.Store(state);
+            return state;
+        }
+
+        StateCacheStats GetStats() const noexcept
+        {
+            return {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed)};
+        }
+
+        static std::string MakeETag(uint32_t session_index, uint64_t tick, uint64_t session_version)
+        {
+            return "\"" + std::to_string(session_index) + "-" + std::to_string(tick) + "-" + std::to_string(session_version) + "\"";
+        }
+
+        // Проверяет заголовок If-None-Match: список меток через запятую, слабые метки W/ и "*"
+        static bool Matches(std::string_view if_none_match, std::string_view etag)
+        {
+            while (!if_none_match.empty())
+            {
+                const size_t comma = if_none_match.find(',');
+                std::string_view tag = if_none_match.substr(0, comma);
+                if_none_match = comma == std::string_view::npos ? std::string_view{} : if_none_match.substr(comma + 1);
+
+                while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t'))
+                    tag.remove_prefix(1);
+                while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+                    tag.remove_suffix(1);
+                if (tag.starts_with("W/"))
+                    tag.remove_prefix(2);
+
+                if (tag == "*" || tag == etag)
+                    return true;
+            }
+            return false;
+        }
+
+    private:
+        util::GrowOnlySlots<util::AtomicSnapshot<CachedState>> slots_;
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+    };
+
+} // namespace http_handler
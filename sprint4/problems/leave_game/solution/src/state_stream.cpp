@@ -0,0 +1,266 @@
+#include "state_stream.h"
+
+namespace http_handler
+{
+    using namespace std::literals;
+
+    StateStreamSession::StateStreamSession(tcp::socket &&socket, std::string token, CommandHandler on_command)
+        : ws_{std::move(socket)}, token_{std::move(token)}, on_command_{std::move(on_command)}
+    {
+    }
+
+    void StateStreamSession::Run(http::request<http::string_body> &&request)
+    {
+        request_ = std::move(request);
+        net::dispatch(ws_.get_executor(), [self = shared_from_this()]
+                      {
+                          // Таймаут HTTP-сессии заменяется пингами WebSocket
+                          beast::get_lowest_layer(self->ws_).expires_never();
+                          self->ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+                          self->ws_.async_accept(self->request_, beast::bind_front_handler(&StateStreamSession::OnAccept, self)); });
+    }
+
+    void StateStreamSession::OnAccept(beast::error_code ec)
+    {
+        if (ec)
+        {
+            closed_ = true;
+            return;
+        }
+
+        ws_.text(true);
+        writing_ = false;
+        if (closing_)
+            return DoClose();
+
+        WriteNext();
+        Read();
+    }
+
+    void StateStreamSession::Push(Frame frame)
+    {
+        net::dispatch(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable
+                      {
+                          if (self->pending_)
+                              self->dropped_.fetch_add(1, std::memory_order_relaxed);
+                          self->pending_ = std::move(frame);
+
+                          if (!self->writing_)
+                              self->WriteNext(); });
+    }
+
+    void StateStreamSession::PushReply(Frame reply)
+    {
+        net::dispatch(ws_.get_executor(), [self = shared_from_this(), reply = std::move(reply)]() mutable
+                      {
+                          self->replies_.push_back(std::move(reply));
+
+                          if (!self->writing_)
+                              self->WriteNext(); });
+    }
+
+    void StateStreamSession::Close()
+    {
+        net::dispatch(ws_.get_executor(), [self = shared_from_this()]
+                      {
+                          if (self->closed_ || self->closing_)
+                              return;
+                          // Закрытие - тоже запись, поэтому ждёт окончания текущего кадра
+                          self->closing_ = true;
+                          if (!self->writing_)
+                              self->DoClose(); });
+    }
+
+    void StateStreamSession::DoClose()
+    {
+        closed_ = true;
+        ws_.async_close(websocket::close_code::normal, [self = shared_from_this()](beast::error_code) {});
+    }
+
+    void StateStreamSession::WriteNext()
+    {
+        if (closed_ || closing_)
+            return;
+
+        if (!replies_.empty())
+        {
+            current_ = std::move(replies_.front());
+            replies_.pop_front();
+        }
+        else if (pending_)
+        {
+            current_ = std::move(pending_);
+            pending_.reset();
+        }
+        else
+        {
+            return;
+        }
+
+        // Буфер принадлежит общему кадру, current_ держит его до конца записи
+        writing_ = true;
+        ws_.async_write(net::buffer(*current_), beast::bind_front_handler(&StateStreamSession::OnWrite, shared_from_this()));
+    }
+
+    void StateStreamSession::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written)
+    {
+        writing_ = false;
+        current_.reset();
+
+        if (ec)
+        {
+            closed_ = true;
+            return;
+        }
+
+        if (closing_)
+            return DoClose();
+
+        WriteNext();
+    }
+
+    void StateStreamSession::Read()
+    {
+        ws_.async_read(buffer_, beast::bind_front_handler(&StateStreamSession::OnRead, shared_from_this()));
+    }
+
+    void StateStreamSession::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read)
+    {
+        if (ec)
+        {
+            // Клиент закрыл соединение или оно оборвалось
+            closed_ = true;
+            return;
+        }
+
+        std::string command = beast::buffers_to_string(buffer_.data());
+        buffer_.consume(buffer_.size());
+
+        on_command_(std::move(command), [weak = weak_from_this()](std::string reply)
+                    {
+                        if (auto self = weak.lock())
+                            self->PushReply(std::make_shared<const std::string>(std::move(reply))); });
+
+        Read();
+    }
+
+    UpgradeCheck StateStream::CheckUpgrade(const http::request<http::string_body> &req, const app::PlayerDirectory &directory)
+    {
+        UpgradeCheck check;
+
+        const std::string_view target = req.target();
+        if (target.substr(0, target.find('?')) != "/api/v1/game/stream"sv)
+        {
+            check.status = http::status::not_found;
+            check.code = "Bad Request"s;
+            check.message = "Unknown stream"s;
+            return check;
+        }
+
+        // Токен проверяется так же, как у HTTP-запросов: заголовок Authorization: Bearer <токен>
+        const auto header = req.find(http::field::authorization);
+        if (header == req.end() || !header->value().starts_with("Bearer "))
+        {
+            check.status = http::status::unauthorized;
+            check.code = "Invalid Token"s;
+            check.message = "Authorization header is required"s;
+            return check;
+        }
+
+        check.token = std::string{header->value().substr(header->value().find(' ') + 1)};
+
+        const auto *player = directory.FindByToken(check.token);
+        if (player == nullptr || !player->dog_handle.IsValid())
+        {
+            check.status = http::status::unauthorized;
+            check.code = "Unknown Token"s;
+            check.message = "Player token has not been found"s;
+            return check;
+        }
+
+        check.player = player;
+        return check;
+    }
+
+    void StateStream::RejectUpgrade(tcp::socket &&socket, const http::request<http::string_body> &req, http::status status, std::string body)
+    {
+        auto stream = std::make_shared<beast::tcp_stream>(std::move(socket));
+        auto response = std::make_shared<http::response<http::string_body>>(status, req.version());
+        response->set(http::field::content_type, "application/json"sv);
+        response->body() = std::move(body);
+        response->prepare_payload();
+        response->keep_alive(false);
+
+        http::async_write(*stream, *response, [stream, response](beast::error_code, std::size_t)
+                          {
+                              beast::error_code ec;
+                              stream->socket().shutdown(tcp::socket::shutdown_send, ec); });
+    }
+
+    void StateStream::Subscribe(uint32_t session_index, const std::shared_ptr<StateStreamSession> &session)
+    {
+        std::lock_guard lock{mutex_};
+        subscribers_[session_index].push_back(session);
+    }
+
+    std::vector<uint32_t> StateStream::GetSubscribedSessions()
+    {
+        std::lock_guard lock{mutex_};
+        std::vector<uint32_t> result;
+        result.reserve(subscribers_.size());
+
+        for (auto it = subscribers_.begin(); it != subscribers_.end();)
+        {
+            auto &sessions = it->second;
+            std::erase_if(sessions, [](const std::weak_ptr<StateStreamSession> &weak)
+                          {
+                              const auto session = weak.lock();
+                              return session == nullptr || !session->IsOpen(); });
+
+            if (sessions.empty())
+            {
+                last_frames_.erase(it->first);
+                it = subscribers_.erase(it);
+                continue;
+            }
+
+            result.push_back(it->first);
+            ++it;
+        }
+        return result;
+    }
+
+    void StateStream::Broadcast(uint32_t session_index, const StateStreamSession::Frame &frame, const app::PlayerDirectory &directory)
+    {
+        std::vector<std::shared_ptr<StateStreamSession>> sessions;
+        {
+            std::lock_guard lock{mutex_};
+            const auto it = subscribers_.find(session_index);
+            if (it == subscribers_.end())
+                return;
+
+            // Кеш состояния отдаёт тот же указатель, пока не сменились тик и игроки сессии
+            auto &last_frame = last_frames_[session_index];
+            if (last_frame == frame)
+                return;
+            last_frame = frame;
+
+            sessions.reserve(it->second.size());
+            for (const auto &weak : it->second)
+            {
+                if (auto session = weak.lock())
+                    sessions.push_back(std::move(session));
+            }
+        }
+
+        // Рассылка идёт без блокировки: Push только ставит кадр в strand сокета
+        for (const auto &session : sessions)
+        {
+            if (directory.FindByToken(session->GetToken()) == nullptr)
+                session->Close();
+            else
+                session->Push(frame);
+        }
+    }
+
+} // namespace http_handler
@@ -0,0 +1,132 @@
+#pragma once
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include "player.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace http_handler
+{
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace websocket = beast::websocket;
+    using tcp = net::ip::tcp;
+
+    /*
+     *  WebSocket-подписка игрока на состояние его сессии. Сервер шлёт кадры состояния,
+     *  клиент - команды в формате тела /api/v1/game/player/action ({"move": "L"}).
+     *  Медленный клиент не копит очередь: пока кадр отправляется, ждёт только самый свежий.
+     */
+    class StateStreamSession : public std::enable_shared_from_this<StateStreamSession>
+    {
+    public:
+        using Frame = std::shared_ptr<const std::string>;
+        using Reply = std::function<void(std::string)>;
+        using CommandHandler = std::function<void(std::string command, Reply reply)>;
+
+        StateStreamSession(tcp::socket &&socket, std::string token, CommandHandler on_command);
+
+        StateStreamSession(const StateStreamSession &) = delete;
+        StateStreamSession &operator=(const StateStreamSession &) = delete;
+
+        // Завершает рукопожатие по уже прочитанному запросу Upgrade
+        void Run(http::request<http::string_body> &&request);
+
+        // Кадр состояния; если предыдущий ещё отправляется, ожидающий кадр заменяется новым
+        void Push(Frame frame);
+
+        void Close();
+
+        const std::string &GetToken() const noexcept
+        {
+            return token_;
+        }
+
+        bool IsOpen() const noexcept
+        {
+            return !closed_.load(std::memory_order_relaxed);
+        }
+
+        // Сколько кадров состояния заменено более свежими
+        uint64_t GetDroppedFrames() const noexcept
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void OnAccept(beast::error_code ec);
+        void Read();
+        void OnRead(beast::error_code ec, std::size_t bytes_read);
+        // Ответы на команды не отбрасываются и уходят раньше кадров состояния
+        void PushReply(Frame reply);
+        void DoClose();
+        void WriteNext();
+        void OnWrite(beast::error_code ec, std::size_t bytes_written);
+
+        websocket::stream<beast::tcp_stream> ws_;
+        std::string token_;
+        CommandHandler on_command_;
+        http::request<http::string_body> request_;
+        beast::flat_buffer buffer_;
+
+        // Поля ниже меняются только в strand сокета; до конца рукопожатия кадры только копятся
+        bool writing_ = true;
+        bool closing_ = false;
+        Frame current_;
+        Frame pending_;
+        std::deque<Frame> replies_;
+
+        std::atomic<bool> closed_{false};
+        std::atomic<uint64_t> dropped_{0};
+    };
+
+    // Итог проверки запроса Upgrade: игрок и его токен или статус отказа с кодом и текстом ошибки
+    struct UpgradeCheck
+    {
+        const app::PlayerEntry *player = nullptr;
+        std::string token;
+        http::status status = http::status::ok;
+        std::string code;
+        std::string message;
+    };
+
+    // Подписчики по индексам игровых сессий; один сериализованный кадр раздаётся всем подписчикам сессии
+    class StateStream
+    {
+    public:
+        // Подписка открывается на /api/v1/game/stream с заголовком Authorization: Bearer <токен> игрока, у которого есть собака
+        static UpgradeCheck CheckUpgrade(const http::request<http::string_body> &req, const app::PlayerDirectory &directory);
+
+        // Отвечает на отклонённый запрос Upgrade обычным HTTP-ответом и закрывает соединение
+        static void RejectUpgrade(tcp::socket &&socket, const http::request<http::string_body> &req, http::status status, std::string body);
+
+        void Subscribe(uint32_t session_index, const std::shared_ptr<StateStreamSession> &session);
+
+        // Сессии, у которых есть открытые подписки; закрытые подписки при этом убираются
+        std::vector<uint32_t> GetSubscribedSessions();
+
+        // Подписки игроков, которых уже нет в справочнике, закрываются.
+        // Кадр, уже разосланный сессии, повторно не отправляется: рассылка после запросов к игре не трогает другие сессии
+        void Broadcast(uint32_t session_index, const StateStreamSession::Frame &frame, const app::PlayerDirectory &directory);
+
+    private:
+        std::mutex mutex_;
+        std::unordered_map<uint32_t, std::vector<std::weak_ptr<StateStreamSession>>> subscribers_;
+        std::unordered_map<uint32_t, StateStreamSession::Frame> last_frames_;
+    };
+
+} // namespace http_handler
@@ -1,4 +1,3 @@
-
 #include "ticker.h"
 
 namespace app
@@ -23,12 +22,33 @@ namespace app
         if (!ec) {
             auto this_tick = Clock::now();
             auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
-            last_tick_ = this_tick;
+            // Остаток меньше миллисекунды переносится на следующее срабатывание
+            last_tick_ += delta;
+
+            const auto steps = accumulator_.Advance(delta);
             try {
-                handler_(delta);
+                for (size_t i = 0; i < steps.run; ++i) {
+                    handler_(accumulator_.GetStep());
+                }
+                if (steps.run > 0 && after_steps_) {
+                    after_steps_(accumulator_.GetStep() * static_cast<int64_t>(steps.run));
+                }
             } catch (...) {
             }
+
+            const auto spent = duration_cast<microseconds>(Clock::now() - this_tick).count();
+            stats_->ticks.fetch_add(1, std::memory_order_relaxed);
+            stats_->steps.fetch_add(steps.run, std::memory_order_relaxed);
+            stats_->skipped_steps.fetch_add(steps.skipped, std::memory_order_relaxed);
+            stats_->last_tick_us.store(spent, std::memory_order_relaxed);
+            if (spent > stats_->max_tick_us.load(std::memory_order_relaxed)) {
+                stats_->max_tick_us.store(spent, std::memory_order_relaxed);
+            }
+            if (spent > duration_cast<microseconds>(period_).count()) {
+                stats_->overruns.fetch_add(1, std::memory_order_relaxed);
+            }
+
             ScheduleTick();
         }
     }
-}
\ No newline at end of file
+}
@@ -2,6 +2,10 @@
 #include <iostream>
 #include <memory>
 #include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <cstdint>
 
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
@@ -11,20 +15,94 @@ namespace app
     namespace net = boost::asio;
     namespace sys = boost::system;
 
+    // Сколько пропущенных шагов тикер догоняет за одно срабатывание таймера
+    constexpr size_t kDefaultMaxCatchUpSteps = 5;
+
+    // Счётчики тикера; читаются из обработчиков запросов
+    struct TickStats {
+        std::atomic<uint64_t> ticks{0};
+        std::atomic<uint64_t> steps{0};
+        // Шаги, отброшенные сверх max_catch_up_steps
+        std::atomic<uint64_t> skipped_steps{0};
+        // Срабатывания, на которые ушло больше периода
+        std::atomic<uint64_t> overruns{0};
+        std::atomic<int64_t> last_tick_us{0};
+        std::atomic<int64_t> max_tick_us{0};
+    };
+
+    /*
+     *  Накопитель фиксированного шага: прошедшее время копится и расходуется целыми шагами,
+     *  за раз выдаётся не больше max_steps шагов, остальные считаются пропущенными.
+     */
+    class FixedStepAccumulator {
+    public:
+        FixedStepAccumulator(std::chrono::milliseconds step, size_t max_steps) noexcept
+            : step_{step}
+            , max_steps_{max_steps} {
+        }
+
+        struct Steps {
+            size_t run = 0;
+            size_t skipped = 0;
+        };
+
+        Steps Advance(std::chrono::milliseconds delta) noexcept {
+            Steps result;
+            if (step_.count() <= 0) {
+                return result;
+            }
+
+            accumulated_ += delta;
+            const auto due = static_cast<size_t>(accumulated_ / step_);
+            accumulated_ -= step_ * static_cast<int64_t>(due);
+
+            result.run = std::min(due, max_steps_);
+            result.skipped = due - result.run;
+            return result;
+        }
+
+        std::chrono::milliseconds GetStep() const noexcept {
+            return step_;
+        }
+
+        std::chrono::milliseconds GetAccumulated() const noexcept {
+            return accumulated_;
+        }
+
+    private:
+        std::chrono::milliseconds step_;
+        size_t max_steps_;
+        std::chrono::milliseconds accumulated_{0};
+    };
+
     class Ticker : public std::enable_shared_from_this<Ticker> {
     public:
         using Strand = net::strand<net::io_context::executor_type>;
         using Handler = std::function<void(std::chrono::milliseconds delta)>;
 
-        // Функция handler будет вызываться внутри strand с интервалом period
-        Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
+        // Функция handler будет вызываться внутри strand шагами длиной period,
+        // после задержки тикер догоняет не больше max_catch_up_steps шагов
+        Ticker(Strand strand, std::chrono::milliseconds period, Handler handler,
+               size_t max_catch_up_steps = kDefaultMaxCatchUpSteps, TickStats *stats = nullptr)
             : strand_{strand}
             , period_{period}
-            , handler_{std::move(handler)} {
+            , handler_{std::move(handler)}
+            , accumulator_{period, max_catch_up_steps}
+            , stats_{stats ? stats : &own_stats_} {
+        }
+
+        // Вызывается один раз за срабатывание после всех шагов с их суммарной длительностью:
+        // работа, не зависящая от числа шагов (сохранение, рассылка), не повторяется при догоне
+        void SetAfterSteps(Handler after_steps) {
+            after_steps_ = std::move(after_steps);
         }
 
         void Start();
 
+        const TickStats &GetStats() const noexcept {
+            return *stats_;
+        }
+
     private:
         void ScheduleTick();
 
@@ -36,6 +114,10 @@ namespace app
         std::chrono::milliseconds period_;
         net::steady_timer timer_{strand_};
         Handler handler_;
+        Handler after_steps_;
         std::chrono::steady_clock::time_point last_tick_;
-    }; 
-}
\ No newline at end of file
+        FixedStepAccumulator accumulator_;
+        TickStats own_stats_;
+        TickStats *stats_;
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+    /*
+     *  Хешированное колесо таймеров. Время делится на интервалы resolution, интервал попадает
+     *  в корзину по модулю числа корзин; срок дальше одного оборота колеса проверяется при каждом
+     *  проходе корзины. Постановка - O(1), продвижение - O(пройденных корзин + сработавших таймеров).
+     */
+    template <typename Value>
+    class TimingWheel
+    {
+    public:
+        using Time = int64_t;
+
+        TimingWheel(Time resolution, size_t buckets_count)
+            : resolution_{resolution > 0 ? resolution : 1}, buckets_(buckets_count > 0 ? buckets_count : 1)
+        {
+        }
+
+        Time GetNow() const noexcept
+        {
+            return now_;
+        }
+
+        size_t Size() const noexcept
+        {
+            return size_;
+        }
+
+        // Срок в прошлом срабатывает при следующем продвижении
+        void Schedule(Time deadline, Value value)
+        {
+            const Time tick = std::max(deadline, now_) / resolution_;
+            buckets_[static_cast<size_t>(tick) % buckets_.size()].push_back({deadline, std::move(value)});
+            ++size_;
+        }
+
+        // Продвигает колесо до момента now и вызывает fn(Value &&) для таймеров со сроком не позже now
+        template <typename Fn>
+        void Advance(Time now, Fn &&fn)
+        {
+            if (now < now_)
+                return;
+
+            const Time first = now_ / resolution_;
+            const Time last = now / resolution_;
+            now_ = now;
+
+            // За один вызов каждая корзина просматривается не больше одного раза
+            const Time passed = std::min<Time>(last - first, static_cast<Time>(buckets_.size()) - 1);
+            for (Time tick = last - passed; tick <= last; ++tick)
+            {
+                auto &bucket = buckets_[static_cast<size_t>(tick) % buckets_.size()];
+                expired_.clear();
+
+                for (size_t i = 0; i < bucket.size();)
+                {
+                    if (bucket[i].deadline <= now)
+                    {
+                        expired_.push_back(std::move(bucket[i].value));
+                        bucket[i] = std::move(bucket.back());
+                        bucket.pop_back();
+                        --size_;
+                    }
+                    else
+                    {
+                        ++i;
+                    }
+                }
+
+                for (auto &value : expired_)
+                {
+                    fn(std::move(value));
+                }
+            }
+        }
+
+        void Clear() noexcept
+        {
+            for (auto &bucket : buckets_)
+                bucket.clear();
+            size_ = 0;
+        }
+
+    private:
+        struct Entry
+        {
+            Time deadline;
+            Value value;
+        };
+
+        Time resolution_;
+        Time now_ = 0;
+        size_t size_ = 0;
+        std::vector<std::vector<Entry>> buckets_;
+        std::vector<Value> expired_;
+    };
+
+} // namespace util
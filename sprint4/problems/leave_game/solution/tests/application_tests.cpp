@@ -0,0 +1,81 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/application.h"
+
+#include <atomic>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+    // Время, за которое ожидающий поток гарантированно успевает дойти до блокировки
+    constexpr auto kSettle = 100ms;
+}
+
+TEST_CASE("Exclusive lock waits for an in-flight shared lock", "Application")
+{
+    model::Game game{true, true};
+    app::Players players;
+    app::Application application{game, players, ""s, 0};
+
+    auto shared = application.LockShared();
+
+    std::atomic<bool> acquired{false};
+    std::thread writer{[&]
+                       {
+                           auto lock = application.LockExclusive();
+                           acquired = true;
+                       }};
+
+    std::this_thread::sleep_for(kSettle);
+    CHECK_FALSE(acquired);
+
+    shared.unlock();
+    writer.join();
+    CHECK(acquired);
+}
+
+TEST_CASE("Waiting exclusive lock blocks new shared lockers", "Application")
+{
+    model::Game game{true, true};
+    app::Players players;
+    app::Application application{game, players, ""s, 0};
+
+    std::mutex order_mutex;
+    std::vector<std::string> order;
+    const auto record = [&](std::string name)
+    {
+        std::lock_guard lock{order_mutex};
+        order.push_back(std::move(name));
+    };
+
+    auto shared = application.LockShared();
+
+    std::thread writer{[&]
+                       {
+                           auto lock = application.LockExclusive();
+                           record("writer"s);
+                       }};
+    std::this_thread::sleep_for(kSettle);
+
+    // Без турникета новый читатель прошёл бы мимо ждущего писателя, пока держится первая блокировка
+    std::atomic<bool> reader_acquired{false};
+    std::thread reader{[&]
+                       {
+                           auto lock = application.LockShared();
+                           reader_acquired = true;
+                           record("reader"s);
+                       }};
+    std::this_thread::sleep_for(kSettle);
+    CHECK_FALSE(reader_acquired);
+
+    shared.unlock();
+    writer.join();
+    reader.join();
+    CHECK(order == std::vector{"writer"s, "reader"s});
+}
@@ -1,9 +1,11 @@
 #define _USE_MATH_DEFINES
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_all.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 
 #include "../src/collision_detector.h"
 
+#include <random>
 #include <sstream>
 
 using namespace collision_detector;
@@ -142,4 +144,94 @@ TEST_CASE("2 of 2 on x-axis and y-axis", "GatherEvents")
     CHECK(events.at(1).gatherer_id == "1");
     CHECK_THAT(events.at(1).sq_distance, WithinRel(0.0, 1e-9));
     CHECK_THAT(events.at(1).time, WithinRel((item1.position.y / gatherer2.end_pos.y), 1e-9));
+}
+
+namespace
+{
+    // Полный перебор всех пар собиратель-предмет, эталон для broad phase
+    std::vector<GatheringEvent> FindGatherEventsBruteForce(const ItemGathererProvider &provider)
+    {
+        std::vector<GatheringEvent> events;
+        for (size_t g = 0; g < provider.GatherersCount(); ++g)
+        {
+            Gatherer gatherer = provider.GetGatherer(g);
+            if (gatherer.start_pos == gatherer.end_pos)
+                continue;
+
+            for (size_t i = 0; i < provider.ItemsCount(); ++i)
+            {
+                Item item = provider.GetItem(i);
+                auto result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
+                if (result.IsCollected(gatherer.width + item.width))
+                    events.push_back({item.id, gatherer.id, result.sq_distance, result.proj_ratio});
+            }
+        }
+
+        std::sort(events.begin(), events.end(), [](const GatheringEvent &l, const GatheringEvent &r)
+                  { return l.time < r.time; });
+        return events;
+    }
+
+    Provider MakeRandomProvider(size_t items, size_t gatherers, double area, unsigned seed)
+    {
+        std::mt19937 gen{seed};
+        std::uniform_real_distribution<double> coord{0.0, area};
+        std::uniform_real_distribution<double> step{-3.0, 3.0};
+
+        Provider provider;
+        for (size_t i = 0; i < items; ++i)
+        {
+            Item item{static_cast<int>(i), {coord(gen), coord(gen)}, i % 5 == 0 ? 0.5 : 0.0};
+            provider.AddItem(item);
+        }
+
+        for (size_t g = 0; g < gatherers; ++g)
+        {
+            geom::Point2D start{coord(gen), coord(gen)};
+            geom::Point2D end = g % 2 == 0 ? geom::Point2D{start.x + step(gen), start.y} : geom::Point2D{start.x, start.y + step(gen)};
+            Gatherer gatherer{std::to_string(g), start, end, 0.6};
+            provider.AddGatherer(gatherer);
+        }
+
+        return provider;
+    }
+} // namespace
+
+TEST_CASE("Broad phase produces the same events as brute force", "GatherEvents")
+{
+    for (unsigned seed = 0; seed < 20; ++seed)
+    {
+        auto provider = MakeRandomProvider(2000, 200, 100.0, seed);
+        auto expected = FindGatherEventsBruteForce(provider);
+        auto events = FindGatherEvents(provider);
+
+        INFO("seed: " << seed);
+        REQUIRE(events.size() == expected.size());
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            CHECK(events[i].item_id == expected[i].item_id);
+            CHECK(events[i].gatherer_id == expected[i].gatherer_id);
+            CHECK(events[i].sq_distance == expected[i].sq_distance);
+            CHECK(events[i].time == expected[i].time);
+        }
+    }
+}
+
+TEST_CASE("Gather events scaling from 10 to 100k items", "[.][benchmark]")
+{
+    for (size_t items : {10u, 100u, 1000u, 10000u, 100000u})
+    {
+        // Плотность предметов постоянна, площадь растёт вместе с их числом
+        const auto provider = MakeRandomProvider(items, 100, std::sqrt(static_cast<double>(items)) * 10.0, 1);
+
+        BENCHMARK("brute force, " + std::to_string(items) + " items")
+        {
+            return FindGatherEventsBruteForce(provider);
+        };
+
+        BENCHMARK("broad phase, " + std::to_string(items) + " items")
+        {
+            return FindGatherEvents(provider);
+        };
+    }
 }
\ No newline at end of file
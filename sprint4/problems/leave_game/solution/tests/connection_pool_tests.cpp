@@ -0,0 +1,212 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/connection_pool.h"
+
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+    namespace net = boost::asio;
+    namespace sys = boost::system;
+
+    // Соединение без базы данных: номер показывает, какое соединение выдано, alive - проходит ли проверку
+    struct FakeConnection
+    {
+        int id = 0;
+        bool alive = true;
+    };
+
+    using FakePool = database::BasicConnectionPool<FakeConnection>;
+
+    struct FakeFactory
+    {
+        std::shared_ptr<int> created = std::make_shared<int>(0);
+        std::shared_ptr<bool> fail = std::make_shared<bool>(false);
+
+        std::shared_ptr<FakeConnection> operator()() const
+        {
+            if (*fail)
+                throw std::runtime_error("connection refused");
+            return std::make_shared<FakeConnection>(FakeConnection{++*created});
+        }
+    };
+
+    std::shared_ptr<FakePool> MakePool(size_t capacity, const FakeFactory &factory)
+    {
+        return std::make_shared<FakePool>(capacity, factory, [](FakeConnection &conn, bool)
+                                          { return conn.alive; });
+    }
+
+    // Обработчики пула приходят с его потоков, поэтому io_context крутится, пока условие не выполнится
+    template <typename Predicate>
+    bool RunUntil(net::io_context &ioc, Predicate &&done)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!done() && std::chrono::steady_clock::now() < deadline)
+        {
+            ioc.restart();
+            ioc.run_for(5ms);
+        }
+        return done();
+    }
+}
+
+TEST_CASE("Waiters get returned connections in arrival order", "ConnectionPool")
+{
+    FakeFactory factory;
+    auto pool = MakePool(1, factory);
+    net::io_context ioc;
+
+    auto held = pool->GetConnection();
+    REQUIRE(held);
+    CHECK(held->id == 1);
+
+    std::vector<int> order;
+    std::vector<FakePool::ConnectionWrapper> handed;
+    for (int waiter = 1; waiter <= 2; ++waiter)
+    {
+        pool->AsyncGetConnection(ioc.get_executor(), [&, waiter](sys::error_code ec, FakePool::ConnectionWrapper conn)
+                                 {
+                                     REQUIRE_FALSE(ec);
+                                     CHECK(conn->id == 1);
+                                     order.push_back(waiter);
+                                     handed.push_back(std::move(conn)); },
+                                 10s);
+    }
+    CHECK(pool->GetStats().waiting == 2);
+
+    // Возвращённое соединение минует список свободных и сразу уходит первому ожидающему
+    held = {};
+    REQUIRE(RunUntil(ioc, [&]
+                     { return order.size() == 1; }));
+    CHECK(order == std::vector{1});
+    CHECK(pool->GetStats().waiting == 1);
+    CHECK(pool->GetStats().in_use == 1);
+
+    handed.clear();
+    REQUIRE(RunUntil(ioc, [&]
+                     { return order.size() == 2; }));
+    CHECK(order == std::vector{1, 2});
+    CHECK(pool->GetStats().waiting == 0);
+
+    handed.clear();
+    CHECK(pool->GetStats().in_use == 0);
+    CHECK(pool->GetStats().acquired == 3);
+    CHECK(*factory.created == 1);
+}
+
+TEST_CASE("Waiter times out and leaves the queue", "ConnectionPool")
+{
+    FakeFactory factory;
+    auto pool = MakePool(1, factory);
+    net::io_context ioc;
+
+    auto held = pool->GetConnection();
+
+    std::optional<sys::error_code> result;
+    pool->AsyncGetConnection(ioc.get_executor(), [&](sys::error_code ec, FakePool::ConnectionWrapper conn)
+                             {
+                                 CHECK_FALSE(conn);
+                                 result = ec; },
+                             20ms);
+    CHECK(pool->GetStats().waiting == 1);
+
+    REQUIRE(RunUntil(ioc, [&]
+                     { return result.has_value(); }));
+    CHECK(*result == sys::errc::timed_out);
+    CHECK(pool->GetStats().waiting == 0);
+    CHECK(pool->GetStats().timeouts == 1);
+
+    // Соединение возвращается в свободные, а не просроченному ожидающему
+    held = {};
+    CHECK(pool->GetStats().in_use == 0);
+    CHECK(pool->GetStats().acquired == 1);
+
+    // Блокирующее получение тоже сдаётся по сроку
+    held = pool->GetConnection();
+    CHECK_THROWS_AS(pool->GetConnection(10ms), std::runtime_error);
+    CHECK(pool->GetStats().waiting == 0);
+    CHECK(pool->GetStats().timeouts == 2);
+}
+
+TEST_CASE("Failed reconnect reports not_connected and keeps the capacity", "ConnectionPool")
+{
+    FakeFactory factory;
+    auto pool = MakePool(1, factory);
+    net::io_context ioc;
+
+    // Соединение оборвалось, пока было выдано
+    {
+        auto conn = pool->GetConnection();
+        conn->alive = false;
+    }
+
+    *factory.fail = true;
+    std::optional<sys::error_code> result;
+    pool->AsyncGetConnection(ioc.get_executor(), [&](sys::error_code ec, FakePool::ConnectionWrapper conn)
+                             {
+                                 CHECK_FALSE(conn);
+                                 result = ec; });
+    REQUIRE(RunUntil(ioc, [&]
+                     { return result.has_value(); }));
+    CHECK(*result == sys::errc::not_connected);
+    CHECK(pool->GetStats().reconnect_failures == 1);
+    CHECK(pool->GetStats().in_use == 0);
+    CHECK(pool->GetStats().capacity == 1);
+
+    // Место в пуле не потеряно: когда база снова доступна, соединение пересоздаётся
+    *factory.fail = false;
+    auto conn = pool->GetConnection();
+    REQUIRE(conn);
+    CHECK(conn->id == 2);
+    CHECK(conn->alive);
+    CHECK(pool->GetStats().reconnects == 1);
+}
+
+TEST_CASE("Concurrent timeouts and returns never lose a connection", "ConnectionPool")
+{
+    constexpr int kThreads = 8;
+    constexpr int kAttempts = 200;
+
+    FakeFactory factory;
+    auto pool = MakePool(2, factory);
+
+    std::atomic<int> acquired{0};
+    std::atomic<int> timed_out{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back([&]
+                             {
+                                 for (int i = 0; i < kAttempts; ++i)
+                                 {
+                                     try
+                                     {
+                                         // Срок ожидания сравним со временем удержания: истечение и возврат гонятся
+                                         auto conn = pool->GetConnection(i % 2 == 0 ? 0ms : 1ms);
+                                         ++acquired;
+                                         std::this_thread::sleep_for(100us);
+                                     }
+                                     catch (const std::runtime_error &)
+                                     {
+                                         ++timed_out;
+                                     }
+                                 } });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    const auto stats = pool->GetStats();
+    CHECK(acquired + timed_out == kThreads * kAttempts);
+    CHECK(stats.acquired == static_cast<uint64_t>(acquired));
+    CHECK(stats.timeouts == static_cast<uint64_t>(timed_out));
+    CHECK(stats.in_use == 0);
+    CHECK(stats.waiting == 0);
+    CHECK(*factory.created == 2);
+}
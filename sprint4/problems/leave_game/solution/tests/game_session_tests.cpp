@@ -0,0 +1,415 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include "../src/model.h"
+
+using namespace std::literals;
+
+namespace
+{
+    model::Map MakeMap(const std::string &id)
+    {
+        model::Map map{model::Map::Id{id}, id};
+        map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 40});
+        map.AddOffice(model::Office{model::Office::Id{"o"s}, {30, 0}, {0, 0}});
+        map.SetDogSpeed(1);
+        map.SetBagCapacity(3);
+        map.BuildRoadGraph();
+        return map;
+    }
+} // namespace
+
+TEST_CASE("Sessions share the map geometry and keep their own loot", "GameSession")
+{
+    model::Game game{false, true};
+    game.AddMap(MakeMap("map1"s));
+
+    const auto map = game.FindMap(model::Map::Id{"map1"s});
+    REQUIRE(map != nullptr);
+
+    const auto handle = game.ConnectToSession("map1"s, "dog"s);
+    auto session = game.FindGameSession(game.GetGameSession(handle.session)->GetId());
+    REQUIRE(session != nullptr);
+
+    // Сессия не забирает карту у игры: список карт и геометрия остаются доступны
+    CHECK(session->GetSharedMap() == map);
+    REQUIRE(game.GetMaps().size() == 1);
+    CHECK(game.GetMaps().front()->GetRoads().size() == 1);
+
+    model::GameSession other{model::GameSession::Id{"other"s}, map};
+    other.GetMapState().AddLoot(model::MapLoot{0, 1, 0, 5.0, 0.0});
+
+    CHECK(&other.GetMap() == &session->GetMap());
+    CHECK(other.GetMapState().GetLoots().Size() == 1);
+    CHECK(session->GetMapState().GetLoots().Size() == 0);
+}
+
+TEST_CASE("Players are spread over map shards", "GameSession")
+{
+    model::Game game{false, true};
+    game.AddMap(MakeMap("map1"s));
+    game.AddMap(MakeMap("map2"s));
+    game.SetMaxPlayersPerSession(2);
+
+    std::vector<model::GameSession *> joined;
+    for (int i = 0; i < 5; ++i)
+    {
+        joined.push_back(game.GetGameSession(game.ConnectToSession("map1"s, "dog"s + std::to_string(i)).session));
+    }
+    const auto *other_map = game.GetGameSession(game.ConnectToSession("map2"s, "dog"s).session);
+
+    const auto shards = game.GetMapSessions(model::Map::Id{"map1"s});
+    REQUIRE(shards.size() == 3);
+    CHECK(shards[0]->GetDogs().size() == 2);
+    CHECK(shards[1]->GetDogs().size() == 2);
+    CHECK(shards[2]->GetDogs().size() == 1);
+
+    CHECK(joined[0] == joined[1]);
+    CHECK(joined[1] != joined[2]);
+    CHECK(other_map->GetMap().GetId() == model::Map::Id{"map2"s});
+    CHECK(game.GetMapSessions(model::Map::Id{"map2"s}).size() == 1);
+
+    // Идентификаторы сессий генерируются и не совпадают с идентификатором карты
+    for (const auto &shard : shards)
+    {
+        CHECK(*shard->GetId() != "map1"s);
+        CHECK(game.FindGameSession(shard->GetId()) == shard);
+    }
+}
+
+TEST_CASE("Dog handles resolve without string lookups", "GameSession")
+{
+    model::Game game{false, true};
+    game.AddMap(MakeMap("map1"s));
+    game.AddMap(MakeMap("map2"s));
+
+    const auto first = game.ConnectToSession("map1"s, "first"s);
+    const auto second = game.ConnectToSession("map1"s, "second"s);
+    const auto other = game.ConnectToSession("map2"s, "first"s);
+
+    REQUIRE(game.FindDog(first) != nullptr);
+    CHECK(*game.FindDog(first)->GetId() == "first"s);
+    CHECK(*game.FindDog(second)->GetId() == "second"s);
+    CHECK(game.FindDog(other) != game.FindDog(first));
+
+    // Ссылка на собаку из другой сессии или с чужим поколением ничего не находит
+    auto *session = game.GetGameSession(first.session);
+    CHECK(session->FindDog(other) == nullptr);
+    CHECK(session->FindDog(model::DogHandle{first.session, first.slot, first.generation + 1}) == nullptr);
+    CHECK(game.FindDog(model::DogHandle{}) == nullptr);
+    CHECK(session->GetHandle(*game.FindDog(second)) == second);
+}
+
+TEST_CASE("Loot population follows the loot generator and the map cap", "GameSession")
+{
+    auto map = MakeMap("map1"s);
+    map.SetMaxLoot(2);
+
+    add_data::GameLoots game_loots;
+    game_loots.AddLoot("map1"s, add_data::Loot{"key"s, "key.obj"s, "obj"s, "#338844"s, 90, 0.03, 10});
+    loot_gen::LootGenerator prototype{1s, 1.0};
+    game_loots.MakeGenerator(prototype);
+
+    model::GameSession session{model::GameSession::Id{"session"s}, std::make_shared<const model::Map>(std::move(map))};
+
+    // Без собак трофеи не появляются
+    for (int i = 0; i < 10; ++i)
+    {
+        session.LootGenerator(game_loots, 5s);
+    }
+    CHECK(session.GetMapState().GetLoots().Size() == 0);
+
+    auto dog = std::make_shared<model::Dog>(model::Dog::Id{"dog"s});
+    session.AddDog(dog, true);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        session.LootGenerator(game_loots, 5s);
+        REQUIRE(session.GetMapState().GetLoots().Size() <= 1);
+    }
+    CHECK(session.GetMapState().GetLoots().Size() == 1);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        auto other = std::make_shared<model::Dog>(model::Dog::Id{"dog"s + std::to_string(i)});
+        session.AddDog(other, true);
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        session.LootGenerator(game_loots, 5s);
+        REQUIRE(session.GetMapState().GetLoots().Size() <= 2);
+    }
+    CHECK(session.GetMapState().GetLoots().Size() == 2);
+}
+
+TEST_CASE("Retired dogs leave the session and free their slots", "GameSession")
+{
+    auto map = MakeMap("map1"s);
+    map.SetRetirementTime(1000);
+
+    model::GameSession session{model::GameSession::Id{"session"s}, std::make_shared<const model::Map>(std::move(map))};
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    auto idle = std::make_shared<model::Dog>(model::Dog::Id{"idle"s});
+    auto busy = std::make_shared<model::Dog>(model::Dog::Id{"busy"s});
+    const auto idle_handle = session.AddDog(idle, true);
+    const auto busy_handle = session.AddDog(busy, true);
+
+    session.FindDog(idle_handle)->SetDirection(""s, 1);
+    session.FindDog(busy_handle)->SetDirection("R"s, 1);
+
+    for (int i = 0; i < 9; ++i)
+    {
+        session.Tick(100ms, records);
+    }
+    CHECK(session.GetDogs().size() == 2);
+    CHECK(session.TakeRetired().empty());
+
+    for (int i = 0; i < 3; ++i)
+    {
+        session.Tick(100ms, records);
+    }
+
+    // Простоявшая дольше срока собака удалена, её ссылка больше ничего не находит
+    const auto retired = session.TakeRetired();
+    REQUIRE(retired.size() == 1);
+    CHECK(retired.front() == idle_handle);
+    CHECK(session.FindDog(idle_handle) == nullptr);
+    REQUIRE(session.GetDogs().size() == 1);
+    CHECK(*session.FindDog(busy_handle)->GetId() == "busy"s);
+
+    // Освободившееся место занимает новая собака с другим поколением
+    auto next = std::make_shared<model::Dog>(model::Dog::Id{"next"s});
+    const auto next_handle = session.AddDog(next, true);
+    CHECK(next_handle.slot == idle_handle.slot);
+    CHECK(next_handle.generation != idle_handle.generation);
+    CHECK(session.FindDog(idle_handle) == nullptr);
+    CHECK(*session.FindDog(next_handle)->GetId() == "next"s);
+}
+
+TEST_CASE("State snapshots are immutable and published after each step", "GameSession")
+{
+    model::GameSession session{model::GameSession::Id{"session"s}, std::make_shared<const model::Map>(MakeMap("map1"s))};
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    auto dog = std::make_shared<model::Dog>(model::Dog::Id{"dog"s});
+    const auto handle = session.AddDog(dog, true);
+    session.FindDog(handle)->SetDirection("R"s, 1);
+
+    const auto before = session.GetSnapshot();
+    REQUIRE(before != nullptr);
+    REQUIRE(before->dogs.size() == 1);
+    CHECK(before->dogs.front().handle == handle);
+    CHECK(before->dogs.front().name == "dog"s);
+    const auto x = before->dogs.front().position.x;
+
+    // Читатель опрашивает снимки, пока шаги идут в основном потоке: номера тиков только растут
+    std::atomic<bool> stop{false};
+    bool monotonic = true;
+    std::thread reader{[&]
+                       {
+                           uint64_t last = 0;
+                           while (!stop.load())
+                           {
+                               const auto snapshot = session.GetSnapshot();
+                               monotonic = monotonic && snapshot->tick >= last && snapshot->dogs.size() == 1;
+                               last = snapshot->tick;
+                           }
+                       }};
+
+    for (int i = 0; i < 100; ++i)
+    {
+        session.Tick(10ms, records);
+        session.PublishTick();
+    }
+    stop = true;
+    reader.join();
+    CHECK(monotonic);
+
+    // Выданный ранее снимок не меняется, новый отражает движение собаки
+    CHECK(before->dogs.front().position.x == x);
+    const auto after = session.GetSnapshot();
+    CHECK(after->tick == before->tick + 100);
+    CHECK(after->dogs.front().position.x > x);
+}
+
+TEST_CASE("Deltas since a tick carry only changed dogs and loot", "GameSession")
+{
+    model::GameSession session{model::GameSession::Id{"session"s}, std::make_shared<const model::Map>(MakeMap("map1"s))};
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    auto moving = std::make_shared<model::Dog>(model::Dog::Id{"moving"s});
+    auto idle = std::make_shared<model::Dog>(model::Dog::Id{"idle"s});
+    const auto moving_handle = session.AddDog(moving, true);
+    const auto idle_handle = session.AddDog(idle, true);
+    session.FindDog(moving_handle)->SetDirection("R"s, 1);
+    session.PublishTick();
+
+    const auto base = session.GetSnapshot()->tick;
+    session.Tick(100ms, records);
+    session.PublishTick();
+    session.Tick(100ms, records);
+    session.PublishTick();
+
+    // Два тика сводятся в одно изменение движущейся собаки, стоящая не упоминается
+    const auto snapshot = session.GetSnapshot();
+    CHECK(snapshot->tick == base + 2);
+    auto delta = snapshot->DeltaSince(base);
+    REQUIRE(delta.has_value());
+    CHECK(delta->tick == snapshot->tick);
+    REQUIRE(delta->changed_dogs.size() == 1);
+    CHECK(delta->changed_dogs.front().handle == moving_handle);
+    CHECK(delta->changed_dogs.front() == snapshot->dogs.front());
+    CHECK(delta->removed_dogs.empty());
+
+    CHECK(snapshot->DeltaSince(snapshot->tick)->changed_dogs.empty());
+
+    // Уход между тиками не меняет номер тика, но виден в ответе на since=<текущий тик>
+    session.DeleteDog(model::Dog::Id{"idle"s});
+    CHECK(session.GetSnapshot()->tick == snapshot->tick);
+    delta = session.GetSnapshot()->DeltaSince(snapshot->tick);
+    REQUIRE(delta.has_value());
+    REQUIRE(delta->removed_dogs.size() == 1);
+    CHECK(delta->removed_dogs.front() == idle_handle);
+    delta = session.GetSnapshot()->DeltaSince(base);
+    REQUIRE(delta.has_value());
+    REQUIRE(delta->removed_dogs.size() == 1);
+
+    // За пределами окна истории и для будущих тиков - только полный снимок
+    for (size_t i = 0; i < model::kStateHistoryWindow; ++i)
+    {
+        session.Tick(10ms, records);
+        session.PublishTick();
+    }
+    CHECK_FALSE(session.GetSnapshot()->DeltaSince(base).has_value());
+    CHECK_FALSE(session.GetSnapshot()->DeltaSince(session.GetSnapshot()->tick + 1).has_value());
+    CHECK(session.GetSnapshot()->history.size() == model::kStateHistoryWindow);
+}
+
+TEST_CASE("Joins between ticks fold into the next tick delta", "GameSession")
+{
+    model::GameSession session{model::GameSession::Id{"session"s}, std::make_shared<const model::Map>(MakeMap("map1"s))};
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    auto first = std::make_shared<model::Dog>(model::Dog::Id{"first"s});
+    session.AddDog(first, true);
+    session.PublishTick();
+    const auto seen = session.GetSnapshot()->tick;
+
+    // Клиент опросил состояние на тике seen, затем между тиками вошёл второй игрок
+    auto second = std::make_shared<model::Dog>(model::Dog::Id{"second"s});
+    const auto second_handle = session.AddDog(second, true);
+    const auto joined = session.GetSnapshot();
+    CHECK(joined->tick == seen);
+    CHECK(joined->dogs.size() == 2);
+    REQUIRE(joined->pending != nullptr);
+
+    // Вход виден и до тика, и в дельте следующего тика - курсор since=seen ничего не теряет
+    auto delta = joined->DeltaSince(seen);
+    REQUIRE(delta.has_value());
+    REQUIRE(delta->changed_dogs.size() == 1);
+    CHECK(delta->changed_dogs.front().handle == second_handle);
+
+    session.Tick(10ms, records);
+    session.PublishTick();
+    const auto ticked = session.GetSnapshot();
+    CHECK(ticked->tick == seen + 1);
+    CHECK(ticked->pending == nullptr);
+    CHECK(ticked->history.back()->tick == ticked->tick);
+
+    delta = ticked->DeltaSince(seen);
+    REQUIRE(delta.has_value());
+    REQUIRE(delta->changed_dogs.size() == 1);
+    CHECK(delta->changed_dogs.front().handle == second_handle);
+}
+
+TEST_CASE("Parallel tick gives the same state as a single thread", "Game")
+{
+    constexpr size_t kDogs = 12;
+    constexpr int kSteps = 200;
+
+    add_data::GameLoots game_loots;
+    game_loots.AddLoot("map1"s, add_data::Loot{"key"s, "key.obj"s, "obj"s, "#338844"s, 90, 0.03, 10});
+    loot_gen::LootGenerator prototype{100ms, 0.5};
+    game_loots.MakeGenerator(prototype);
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    // Одинаковые игры: то же зерно, те же карты и игроки, шарды по два игрока
+    const auto make_game = [&](unsigned threads)
+    {
+        auto game = std::make_unique<model::Game>(false, false);
+        auto map = MakeMap("map1"s);
+        map.SetMaxLoot(6);
+        game->AddMap(std::move(map));
+        game->SetMaxPlayersPerSession(2);
+        game->SetRandomSeed(42);
+        game->SetTickThreads(threads);
+
+        for (size_t i = 0; i < kDogs; ++i)
+        {
+            const auto handle = game->ConnectToSession("map1"s, "dog"s + std::to_string(i));
+            game->FindDog(handle)->SetDirection(i % 2 == 0 ? "R"s : "L"s, 1);
+        }
+        return game;
+    };
+
+    auto single = make_game(1);
+    auto parallel = make_game(4);
+    REQUIRE(parallel->GetTickThreads() == 4);
+    REQUIRE(single->GetGameSessions().size() == kDogs / 2);
+
+    for (int step = 0; step < kSteps; ++step)
+    {
+        // Собаки разворачиваются, чтобы снова проходить мимо трофеев и офиса
+        if (step % 50 == 25)
+        {
+            for (auto *game : {single.get(), parallel.get()})
+            {
+                for (const auto &session : game->GetGameSessions())
+                {
+                    for (const auto &dog : session->GetDogs())
+                        dog->SetDirection(dog->GetDirection() == "R"s ? "L"s : "R"s, 1);
+                }
+            }
+        }
+        single->Tick(100ms, game_loots, records);
+        parallel->Tick(100ms, game_loots, records);
+    }
+
+    bool collected = false;
+    for (uint32_t index = 0; index < single->GetGameSessions().size(); ++index)
+    {
+        const auto expected = single->GetSessionSnapshot(index);
+        const auto actual = parallel->GetSessionSnapshot(index);
+        REQUIRE(expected != nullptr);
+        REQUIRE(actual != nullptr);
+        CHECK(actual->tick == expected->tick);
+
+        REQUIRE(actual->dogs.size() == expected->dogs.size());
+        for (size_t i = 0; i < expected->dogs.size(); ++i)
+        {
+            const auto &want = expected->dogs[i];
+            const auto &got = actual->dogs[i];
+            CHECK(got.handle == want.handle);
+            CHECK(got.name == want.name);
+            CHECK(got.position.x == want.position.x);
+            CHECK(got.position.y == want.position.y);
+            CHECK(got.speed.x == want.speed.x);
+            CHECK(got.speed.y == want.speed.y);
+            CHECK(got.direction == want.direction);
+            CHECK(got.bag == want.bag);
+            CHECK(got.score == want.score);
+            collected = collected || want.score > 0 || !want.bag.empty();
+        }
+
+        REQUIRE(actual->loots.size() == expected->loots.size());
+        for (size_t i = 0; i < expected->loots.size(); ++i)
+            CHECK(actual->loots[i] == expected->loots[i]);
+    }
+
+    // Сравнение имеет смысл, только если собаки действительно подбирали трофеи
+    CHECK(collected);
+}
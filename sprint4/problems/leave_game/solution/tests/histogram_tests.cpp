@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "../src/histogram.h"
+
+TEST_CASE("Log-linear histogram keeps quantiles within one sub-bucket", "Histogram")
+{
+    util::LogLinearHistogram histogram;
+    CHECK(histogram.GetPercentile(0.5) == 0);
+
+    for (uint64_t value = 1; value <= 10'000; ++value)
+    {
+        histogram.Record(value * 1000);
+    }
+
+    REQUIRE(histogram.GetCount() == 10'000);
+    CHECK(histogram.GetMax() == 10'000'000);
+
+    const auto p50 = histogram.GetPercentile(0.5);
+    CHECK(p50 >= 5'000'000);
+    CHECK(p50 <= 5'000'000 + 5'000'000 / util::LogLinearHistogram::kSubBuckets);
+
+    const auto p99 = histogram.GetPercentile(0.99);
+    CHECK(p99 >= 9'900'000);
+    CHECK(p99 <= 10'000'000);
+    CHECK(histogram.GetPercentile(1.0) == 10'000'000);
+
+    for (uint64_t value : {0ull, 7ull, 8ull, 1023ull, 1ull << 40, ~0ull})
+    {
+        const auto bucket = util::LogLinearHistogram::BucketOf(value);
+        REQUIRE(bucket < util::LogLinearHistogram::kBucketsCount);
+        CHECK(util::LogLinearHistogram::UpperBoundOf(bucket) >= value);
+    }
+
+    util::LogLinearHistogram merged;
+    merged.Merge(histogram);
+    merged.Merge(histogram);
+    CHECK(merged.GetCount() == 20'000);
+    CHECK(merged.GetPercentile(0.5) == p50);
+
+    histogram.Reset();
+    CHECK(histogram.GetCount() == 0);
+    CHECK(histogram.GetMax() == 0);
+}
+
+TEST_CASE("Scoped timer overhead", "[.][benchmark]")
+{
+    util::LogLinearHistogram histogram;
+
+    BENCHMARK("ScopedTimer, profiling disabled")
+    {
+        util::ScopedTimer timer{nullptr};
+        return 0;
+    };
+
+    BENCHMARK("ScopedTimer, profiling enabled")
+    {
+        util::ScopedTimer timer{&histogram};
+        return 0;
+    };
+}
@@ -0,0 +1,78 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/database.h"
+
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+    std::string Names(std::span<const database::PlayerRecord> records)
+    {
+        std::string result;
+        for (const auto &record : records)
+        {
+            result += record.GetName() + ";"s;
+        }
+        return result;
+    }
+} // namespace
+
+TEST_CASE("Leaderboard serves cached pages until the table changes", "Leaderboard")
+{
+    database::Leaderboard leaderboard{3};
+    leaderboard.Seed({{"b"s, 10, 5}, {"a"s, 20, 5}, {"c"s, 10, 3}}, true);
+
+    size_t serialized = 0;
+    const auto serializer = [&serialized](std::span<const database::PlayerRecord> records)
+    {
+        ++serialized;
+        return Names(records);
+    };
+
+    // Порядок как у запроса к базе: очки по убыванию, затем время игры по возрастанию
+    const auto page = leaderboard.GetPage(0, 10, serializer);
+    REQUIRE(page != nullptr);
+    CHECK(*page == "a;c;b;"s);
+    CHECK(leaderboard.GetPage(0, 10, serializer) == page);
+    CHECK(serialized == 1);
+    CHECK(*leaderboard.GetPage(1, 1, serializer) == "c;"s);
+    CHECK(*leaderboard.GetPage(5, 10, serializer) == ""s);
+
+    // Новый рекорд сбрасывает кеш; вытесненная строка делает таблицу неполной
+    leaderboard.Add({{"d"s, 15, 1}});
+    REQUIRE(leaderboard.GetPage(0, 3, serializer) != nullptr);
+    CHECK(*leaderboard.GetPage(0, 3, serializer) == "a;d;c;"s);
+    CHECK(leaderboard.GetPage(2, 2, serializer) == nullptr);
+
+    // Рекорд ниже последней хранимой строки таблицу и кеш не меняет
+    leaderboard.Add({{"e"s, 1, 1}});
+    CHECK(*leaderboard.GetPage(0, 3, serializer) == "a;d;c;"s);
+
+    const auto stats = leaderboard.GetStats();
+    CHECK(stats.hits == 3);
+    CHECK(stats.fallbacks == 1);
+    CHECK(stats.size == 3);
+}
+
+TEST_CASE("Leaderboard pages continue after a cursor record", "Leaderboard")
+{
+    database::Leaderboard leaderboard{4};
+    leaderboard.Seed({{"a"s, 20, 5}, {"b"s, 10, 5}, {"c"s, 10, 3}, {"d"s, 10, 3}, {"e"s, 5, 1}}, false);
+
+    const auto serializer = [](std::span<const database::PlayerRecord> records)
+    {
+        return Names(records);
+    };
+
+    CHECK(*leaderboard.GetPageAfter({"a"s, 20, 5}, 2, serializer) == "c;d;"s);
+    CHECK(*leaderboard.GetPageAfter({"c"s, 10, 3}, 2, serializer) == "d;b;"s);
+
+    // Курсор между строками: страница начинается со следующей по порядку
+    CHECK(*leaderboard.GetPageAfter({"cc"s, 10, 3}, 1, serializer) == "d;"s);
+
+    // Продолжение за хранимыми строками читается из базы
+    CHECK(leaderboard.GetPageAfter({"b"s, 10, 5}, 1, serializer) == nullptr);
+}
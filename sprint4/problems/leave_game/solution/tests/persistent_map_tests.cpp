@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/persistent_map.h"
+
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+    // Все ключи в одном ведре: проверяет лист на последнем уровне дерева
+    struct CollidingHash
+    {
+        size_t operator()(int) const noexcept
+        {
+            return 42;
+        }
+    };
+}
+
+TEST_CASE("Persistent map keeps previous versions intact", "PersistentHashMap")
+{
+    constexpr int kKeys = 10'000;
+
+    util::PersistentHashMap<int, std::string> map;
+    std::vector<util::PersistentHashMap<int, std::string>> versions;
+    for (int key = 0; key < kKeys; ++key)
+    {
+        map = map.Insert(key, std::to_string(key));
+        if (key % 1000 == 0)
+            versions.push_back(map);
+    }
+
+    REQUIRE(map.Size() == kKeys);
+    for (int key = 0; key < kKeys; ++key)
+    {
+        const std::string *value = map.Find(key);
+        REQUIRE(value != nullptr);
+        CHECK(*value == std::to_string(key));
+    }
+    CHECK(map.Find(kKeys) == nullptr);
+
+    for (size_t i = 0; i < versions.size(); ++i)
+    {
+        const int last = static_cast<int>(i) * 1000;
+        CHECK(versions[i].Size() == static_cast<size_t>(last + 1));
+        CHECK(versions[i].Find(last) != nullptr);
+        CHECK(versions[i].Find(last + 1) == nullptr);
+    }
+
+    SECTION("Insert replaces the value of an existing key")
+    {
+        const auto updated = map.Insert(7, "seven"s);
+        CHECK(updated.Size() == map.Size());
+        CHECK(*updated.Find(7) == "seven"s);
+        CHECK(*map.Find(7) == "7"s);
+    }
+
+    SECTION("Erase removes keys only from the new version")
+    {
+        auto erased = map;
+        for (int key = 0; key < kKeys; key += 2)
+            erased = erased.Erase(key);
+
+        CHECK(erased.Size() == kKeys / 2);
+        for (int key = 0; key < kKeys; ++key)
+            CHECK((erased.Find(key) != nullptr) == (key % 2 == 1));
+        CHECK(map.Size() == kKeys);
+        CHECK(map.Find(0) != nullptr);
+
+        const auto same = erased.Erase(0);
+        CHECK(same.Size() == erased.Size());
+
+        for (int key = 1; key < kKeys; key += 2)
+            erased = erased.Erase(key);
+        CHECK(erased.Empty());
+        CHECK(erased.Find(1) == nullptr);
+    }
+}
+
+TEST_CASE("Persistent map handles full hash collisions", "PersistentHashMap")
+{
+    util::PersistentHashMap<int, int, CollidingHash> map;
+    for (int key = 0; key < 100; ++key)
+        map = map.Insert(key, key * 2);
+
+    REQUIRE(map.Size() == 100);
+    for (int key = 0; key < 100; ++key)
+        CHECK(*map.Find(key) == key * 2);
+
+    map = map.Erase(50);
+    CHECK(map.Size() == 99);
+    CHECK(map.Find(50) == nullptr);
+    CHECK(*map.Find(51) == 102);
+}
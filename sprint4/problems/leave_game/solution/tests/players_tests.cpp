@@ -0,0 +1,54 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/player.h"
+
+using namespace std::literals;
+
+TEST_CASE("Unknown and retired tokens resolve to no session", "Players")
+{
+    app::Players players;
+    const model::DogHandle handle{3, 0, 1};
+    const auto token = players.AddPlayer("dog"s, app::GameSessionId{"session"s}, handle);
+    REQUIRE(token.size() == 32);
+
+    const auto directory = players.GetDirectory();
+    CHECK(directory->FindSession(token) == 3u);
+
+    // Неизвестный, испорченный и пустой токены не бросают исключений
+    CHECK_FALSE(directory->FindSession(std::string(32, '0')).has_value());
+    CHECK_FALSE(directory->FindSession("not a token"s).has_value());
+    CHECK_FALSE(directory->FindSession(""s).has_value());
+
+    // Токен ушедшего игрока больше ничего не находит
+    players.DeletePlayer(handle);
+    CHECK_FALSE(players.GetDirectory()->FindSession(token).has_value());
+    CHECK(directory->FindSession(token) == 3u);
+
+    // Ушедший игрок остаётся в справочнике для ответов ?since=
+    CHECK(players.GetDirectory()->FindPlayerId(handle) == 1u);
+    CHECK(players.GetDirectory()->version == directory->version + 1);
+}
+
+TEST_CASE("Session versions change only for the session a player joins or leaves", "Players")
+{
+    app::Players players;
+    const model::DogHandle first{0, 0, 1};
+    const model::DogHandle second{1, 0, 1};
+
+    players.AddPlayer("first"s, app::GameSessionId{"a"s}, first);
+    const auto before = players.GetDirectory();
+    CHECK(before->SessionVersion(0) == 1u);
+    CHECK(before->SessionVersion(1) == 0u);
+
+    // Вход в другую сессию не сбрасывает кеш состояния первой
+    players.AddPlayer("second"s, app::GameSessionId{"b"s}, second);
+    const auto joined = players.GetDirectory();
+    CHECK(joined->SessionVersion(0) == before->SessionVersion(0));
+    CHECK(joined->SessionVersion(1) == 1u);
+
+    players.DeletePlayer(first);
+    const auto left = players.GetDirectory();
+    CHECK(left->SessionVersion(0) == 2u);
+    CHECK(left->SessionVersion(1) == joined->SessionVersion(1));
+    CHECK(before->SessionVersion(0) == 1u);
+}
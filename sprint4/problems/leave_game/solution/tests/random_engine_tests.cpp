@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "../src/random_engine.h"
+#include "../src/model.h"
+
+#include <boost/random.hpp>
+
+#include <ctime>
+
+using namespace std::literals;
+
+namespace
+{
+    model::Game MakeSeededGame(uint64_t seed)
+    {
+        model::Map map{model::Map::Id{"map"s}, "map"s};
+        map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 40});
+        map.AddRoad(model::Road{model::Road::VERTICAL, {0, 0}, 30});
+        map.SetDogSpeed(1);
+
+        model::Game game{false, false};
+        game.AddMap(std::move(map));
+        game.SetRandomSeed(seed);
+        return game;
+    }
+} // namespace
+
+TEST_CASE("RandomEngine is reproducible and stays in range", "RandomEngine")
+{
+    util::RandomEngine first{42};
+    util::RandomEngine second{42};
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(first() == second());
+    }
+
+    const auto saved = first.GetState();
+    const auto expected = first.NextInt(-5, 5);
+    first.SetState(saved);
+    CHECK(first.NextInt(-5, 5) == expected);
+
+    bool seen_low = false;
+    bool seen_high = false;
+    for (int i = 0; i < 10'000; ++i)
+    {
+        const auto value = first.NextInt(7, -3);
+        REQUIRE(value >= -3);
+        REQUIRE(value <= 7);
+        seen_low |= value == -3;
+        seen_high |= value == 7;
+
+        const double unit = first.NextDouble();
+        REQUIRE(unit >= 0.0);
+        REQUIRE(unit < 1.0);
+    }
+    CHECK(seen_low);
+    CHECK(seen_high);
+}
+
+TEST_CASE("Sessions seeded from config spawn the same dogs", "RandomEngine")
+{
+    auto first = MakeSeededGame(7);
+    auto second = MakeSeededGame(7);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        const auto name = "dog"s + std::to_string(i);
+        const auto *dog_a = first.FindDog(first.ConnectToSession("map"s, name));
+        const auto *dog_b = second.FindDog(second.ConnectToSession("map"s, name));
+
+        REQUIRE(dog_a != nullptr);
+        REQUIRE(dog_b != nullptr);
+        CHECK(dog_a->GetPosition().x == dog_b->GetPosition().x);
+        CHECK(dog_a->GetPosition().y == dog_b->GetPosition().y);
+        CHECK(dog_a->GetRoadSegment() == dog_b->GetRoadSegment());
+        CHECK(dog_a->GetRoadSegment() < first.FindMap(model::Map::Id{"map"s})->GetRoadGraph().SegmentsCount());
+    }
+}
+
+TEST_CASE("Spawn coordinate generation", "[.][benchmark]")
+{
+    constexpr int kDraws = 10'000;
+
+    // Прежний GameSession::GenerateNum: новый mt19937, засеянный временем, на каждое число
+    BENCHMARK("mt19937 seeded per call, 10k numbers")
+    {
+        int64_t sum = 0;
+        for (int i = 0; i < kDraws; ++i)
+        {
+            boost::random::mt19937 gen;
+            gen.seed(static_cast<unsigned int>(std::time(0)));
+            boost::random::uniform_int_distribution<> dist(0, 100);
+            sum += dist(gen);
+        }
+        return sum;
+    };
+
+    util::RandomEngine engine{1};
+    BENCHMARK("RandomEngine::NextInt, 10k numbers")
+    {
+        int64_t sum = 0;
+        for (int i = 0; i < kDraws; ++i)
+        {
+            sum += engine.NextInt(0, 100);
+        }
+        return sum;
+    };
+
+    std::vector<double> draws(kDraws);
+    BENCHMARK("RandomEngine::FillDoubles, 10k numbers")
+    {
+        engine.FillDoubles(draws);
+        return draws.back();
+    };
+}
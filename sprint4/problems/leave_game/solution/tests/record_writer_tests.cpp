@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "../src/database.h"
+#include "../src/mpsc_queue.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("MPSC queue delivers every value exactly once", "RecordWriter")
+{
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 10'000;
+
+    util::MpscQueue<int> queue{1000};
+    REQUIRE(queue.Capacity() == 1024);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p)
+    {
+        producers.emplace_back([&queue, p]
+                               {
+                                   for (int i = 0; i < kPerProducer; ++i)
+                                   {
+                                       while (!queue.TryPush(p * kPerProducer + i))
+                                       {
+                                           std::this_thread::yield();
+                                       }
+                                   } });
+    }
+
+    std::vector<int> seen(kProducers * kPerProducer, 0);
+    // Значения одного писателя приходят в порядке записи
+    std::vector<int> last(kProducers, -1);
+    for (int received = 0; received < kProducers * kPerProducer;)
+    {
+        if (auto value = queue.TryPop())
+        {
+            ++seen[*value];
+            const int producer = *value / kPerProducer;
+            REQUIRE(*value > last[producer]);
+            last[producer] = *value;
+            ++received;
+        }
+    }
+
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    CHECK(!queue.TryPop());
+    CHECK(std::count(seen.begin(), seen.end(), 1) == kProducers * kPerProducer);
+}
+
+TEST_CASE("RecordWriter writes records in batches and counts drops", "RecordWriter")
+{
+    std::mutex mutex;
+    std::vector<size_t> batch_sizes;
+    std::vector<std::string> names;
+
+    database::RecordWriter writer{[&](const std::vector<database::PlayerRecord> &records)
+                                  {
+                                      std::lock_guard lock{mutex};
+                                      batch_sizes.push_back(records.size());
+                                      for (const auto &record : records)
+                                          names.push_back(record.GetName());
+                                  },
+                                  8, 4};
+
+    for (int i = 0; i < 6; ++i)
+    {
+        writer.Push(database::PlayerRecord{"dog"s + std::to_string(i), 1, 1000});
+    }
+    writer.Flush();
+
+    {
+        std::lock_guard lock{mutex};
+        REQUIRE(names.size() == 6);
+        CHECK(names.front() == "dog0"s);
+        CHECK(names.back() == "dog5"s);
+        for (size_t size : batch_sizes)
+            CHECK(size <= 4);
+    }
+
+    writer.Stop();
+    CHECK_FALSE(writer.Push(database::PlayerRecord{"late"s, 1, 1}));
+
+    const auto stats = writer.GetStats();
+    CHECK(stats.enqueued == 6);
+    CHECK(stats.written == 6);
+    CHECK(stats.dropped == 1);
+    CHECK(stats.capacity == 8);
+}
+
+TEST_CASE("Retired dog record latency", "[.][benchmark]")
+{
+    // Медленная база: каждая транзакция - круг по сети
+    auto slow_database = [](const std::vector<database::PlayerRecord> &)
+    {
+        std::this_thread::sleep_for(200us);
+    };
+
+    BENCHMARK("Synchronous write per record")
+    {
+        slow_database({database::PlayerRecord{"dog"s, 1, 1000}});
+    };
+
+    database::RecordWriter writer{slow_database, 1 << 16};
+    BENCHMARK("RecordWriter::Push")
+    {
+        return writer.Push(database::PlayerRecord{"dog"s, 1, 1000});
+    };
+}
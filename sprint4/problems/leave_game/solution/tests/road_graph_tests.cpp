@@ -0,0 +1,103 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model.h"
+
+#include <limits>
+
+using namespace std::literals;
+
+TEST_CASE("Road graph merges collinear roads and links intersections", "RoadGraph")
+{
+    using Graph = model::RoadGraph;
+
+    model::Map map{model::Map::Id{"map"s}, "map"s};
+    // Две касающиеся дороги одной улицы и две пересекающие её
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {20, 0}, 10});
+    map.AddRoad(model::Road{model::Road::VERTICAL, {5, -5}, 5});
+    map.AddRoad(model::Road{model::Road::VERTICAL, {20, 0}, 10});
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {5, 5}, 20});
+    map.BuildRoadGraph();
+
+    const Graph &graph = map.GetRoadGraph();
+    REQUIRE(graph.IsBuilt());
+    REQUIRE(graph.SegmentsCount() == 4);
+    CHECK(graph.SegmentOfRoad(0) == graph.SegmentOfRoad(1));
+
+    const auto &street = graph.GetSegment(graph.SegmentOfRoad(0));
+    CHECK(street.horizontal);
+    CHECK(street.from == 0);
+    CHECK(street.to == 20);
+    CHECK(street.nodes.size() == 3);
+
+    const auto crossing = graph.FindNode(5, 0);
+    REQUIRE(crossing != Graph::kNone);
+    CHECK(graph.FindNodeOnSegment(graph.SegmentOfRoad(0), 5) == crossing);
+    CHECK(graph.FindNodeOnSegment(graph.SegmentOfRoad(0), 6) == Graph::kNone);
+    CHECK(graph.GetNode(crossing).vertical == graph.SegmentOfRoad(2));
+    CHECK(graph.GetNode(crossing).neighbours[Graph::kWest] == graph.FindNode(0, 0));
+    CHECK(graph.GetNode(crossing).neighbours[Graph::kEast] == graph.FindNode(20, 0));
+    CHECK(graph.GetNode(crossing).neighbours[Graph::kNorth] == graph.FindNode(5, -5));
+    CHECK(graph.GetNode(crossing).neighbours[Graph::kSouth] == graph.FindNode(5, 5));
+    CHECK(graph.FindNode(10, 0) == Graph::kNone);
+
+    const auto route = graph.FindRoute(graph.FindNode(0, 0), graph.FindNode(20, 10));
+    CHECK(route.length == 30);
+    REQUIRE(route.nodes.size() == 5);
+    CHECK(route.nodes.front() == graph.FindNode(0, 0));
+    CHECK(route.nodes.back() == graph.FindNode(20, 10));
+
+    model::Map island{model::Map::Id{"island"s}, "island"s};
+    island.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+    island.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 5}, 10});
+    island.BuildRoadGraph();
+    const Graph &islands = island.GetRoadGraph();
+    CHECK(islands.FindRoute(islands.FindNode(0, 0), islands.FindNode(0, 5)).nodes.empty());
+}
+
+TEST_CASE("Dogs turn only at intersections of the road graph", "RoadGraph")
+{
+    model::Map map{model::Map::Id{"map"s}, "map"s};
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {10, 0}, 20});
+    map.AddRoad(model::Road{model::Road::VERTICAL, {15, 0}, 10});
+    map.SetDogSpeed(1);
+    map.SetRetirementTime(std::numeric_limits<uint32_t>::max());
+    map.BuildRoadGraph();
+
+    model::GameSession session{model::GameSession::Id{"map"s}, std::make_shared<const model::Map>(std::move(map))};
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    auto added = std::make_shared<model::Dog>(model::Dog::Id{"dog"s});
+    added->SetPosition(9, 0);
+    const auto handle = session.AddDog(added);
+    auto *dog = session.FindDog(handle);
+    REQUIRE(dog != nullptr);
+
+    // Стык двух дорог одной улицы не останавливает собаку
+    dog->SetDirection("R"s, 1);
+    session.Tick(3s, records);
+    CHECK(dog->GetPosition().x == 12.0);
+    CHECK(dog->GetSpeed().x == 1.0);
+
+    // Вне перекрёстка свернуть нельзя
+    dog->SetDirection("D"s, 1);
+    session.Tick(1s, records);
+    CHECK(dog->GetPosition().x == 12.0);
+    CHECK(dog->GetPosition().y == 0.0);
+    CHECK(dog->GetSpeed().y == 0.0);
+
+    dog->SetDirection("R"s, 1);
+    session.Tick(3s, records);
+    CHECK(dog->GetPosition().x == 15.0);
+
+    // На перекрёстке собака уходит на вертикальную дорогу и останавливается в её конце
+    dog->SetDirection("D"s, 1);
+    session.Tick(4s, records);
+    CHECK(dog->GetPosition().y == 4.0);
+    session.Tick(10s, records);
+    CHECK(dog->GetPosition().x == 15.0);
+    CHECK(dog->GetPosition().y == 10.0);
+    CHECK(dog->GetSpeed().y == 0.0);
+    CHECK(dog->GetRoadSegment() == session.GetMap().GetRoadGraph().SegmentOfRoad(2));
+}
@@ -0,0 +1,238 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "../src/model.h"
+
+#include <limits>
+#include <random>
+
+using namespace std::literals;
+
+namespace
+{
+    constexpr int kLines = 100;
+    constexpr int kSegmentsPerLine = 50;
+    constexpr int kSegmentLength = 10;
+    constexpr int kLineSpacing = 5;
+
+    // Сетка улиц, нарезанных на отрезки: 2 * kLines * kSegmentsPerLine = 10 000 дорог
+    model::Map MakeGridMap()
+    {
+        model::Map map{model::Map::Id{"grid"s}, "grid"s};
+
+        for (int line = 0; line < kLines; ++line)
+        {
+            const int offset = line * kLineSpacing;
+            for (int segment = 0; segment < kSegmentsPerLine; ++segment)
+            {
+                const int start = segment * kSegmentLength;
+                map.AddRoad(model::Road{model::Road::HORIZONTAL, {start, offset}, start + kSegmentLength});
+                map.AddRoad(model::Road{model::Road::VERTICAL, {offset, start}, start + kSegmentLength});
+            }
+        }
+
+        map.SetDogSpeed(1);
+        map.SetRetirementTime(std::numeric_limits<uint32_t>::max());
+        map.BuildRoadGraph();
+        return map;
+    }
+
+    template <typename T>
+    bool InBounds(T value, T low, T high)
+    {
+        if (low > high)
+            std::swap(low, high);
+        return value >= low && value <= high;
+    }
+
+    // Прежний способ поиска из Dog::Tick: копия всех дорог и линейный перебор
+    const model::Road *LinearFindRoadAt(const model::Map &map, model::Point point, bool horizontal, bool &found_any)
+    {
+        auto roads = map.GetRoads();
+        found_any = false;
+
+        for (size_t i = 0; i < roads.size(); ++i)
+        {
+            const auto &road = roads[i];
+            if (!InBounds(point.x, road.GetStart().x, road.GetEnd().x) || !InBounds(point.y, road.GetStart().y, road.GetEnd().y))
+                continue;
+
+            found_any = true;
+            if (horizontal ? road.IsHorizontal() : road.IsVertical())
+                return &map.GetRoads()[i];
+        }
+
+        return nullptr;
+    }
+
+    std::vector<model::Point> RandomPoints(size_t count, int max_coord)
+    {
+        std::mt19937 gen{42};
+        std::uniform_int_distribution<int> dist{-2, max_coord + 2};
+
+        std::vector<model::Point> points;
+        points.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            points.push_back({dist(gen), dist(gen)});
+        }
+        return points;
+    }
+} // namespace
+
+TEST_CASE("Road index finds the same roads as a linear scan", "RoadIndex")
+{
+    const auto map = MakeGridMap();
+
+    for (const auto &point : RandomPoints(2000, kLines * kLineSpacing))
+    {
+        for (bool horizontal : {true, false})
+        {
+            bool found_any = false;
+            const auto *expected = LinearFindRoadAt(map, point, horizontal, found_any);
+
+            INFO("point: " << point.x << ", " << point.y);
+            CHECK(map.HasRoadAt(point) == found_any);
+            CHECK(map.FindRoadAt(point, horizontal) == expected);
+        }
+    }
+}
+
+TEST_CASE("Road index keeps roads in load order", "RoadIndex")
+{
+    model::Map map{model::Map::Id{"map"s}, "map"s};
+    map.AddRoad(model::Road{model::Road::VERTICAL, {3, 0}, 10});
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 5}, 40});
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {40, 5}, 0});
+
+    CHECK(map.HasRoadAt({3, 5}));
+    CHECK(!map.HasRoadAt({41, 6}));
+    CHECK(map.FindRoadAt({3, 5}, true) == &map.GetRoads()[1]);
+    CHECK(map.FindRoadAt({3, 5}, false) == &map.GetRoads()[0]);
+    CHECK(map.FindRoadAt({20, 5}, false) == nullptr);
+}
+
+TEST_CASE("Dog collects loot found through the loot index", "LootIndex")
+{
+    model::Map map{model::Map::Id{"map"s}, "map"s};
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 40});
+    map.AddOffice(model::Office{model::Office::Id{"o"s}, {30, 0}, {0, 0}});
+    map.SetDogSpeed(4);
+    map.SetBagCapacity(3);
+    map.SetRetirementTime(std::numeric_limits<uint32_t>::max());
+    map.BuildRoadGraph();
+
+    model::GameSession session{model::GameSession::Id{"map"s}, std::make_shared<const model::Map>(std::move(map))};
+    const int near_loot = session.GetMapState().AddLoot(model::MapLoot{0, 10, 0, 3.0, 0.0});
+    const int far_loot = session.GetMapState().AddLoot(model::MapLoot{0, 20, 0, 20.0, 0.0});
+
+    auto dog = std::make_shared<model::Dog>(model::Dog::Id{"dog"s});
+    dog->SetPosition(0, 0);
+    dog->SetDirection("R"s, session.GetMap().GetDogSpeed());
+    session.AddDog(dog);
+    dog = session.FindDog(model::Dog::Id{"dog"s});
+    REQUIRE(dog != nullptr);
+
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    // Стоящая собака ничего не подбирает
+    session.FindCollision();
+    CHECK(dog->GetBagSize() == 0);
+
+    session.Tick(1s, records);
+    session.FindCollision();
+    CHECK(dog->GetBagSize() == 1);
+    REQUIRE(session.GetMapState().GetLoots().Size() == 1);
+    CHECK(session.GetMapState().GetLoots().GetValues().front().id_ == far_loot);
+
+    // Трофей подобран и убран из индекса: повторно его не найти
+    int found = 0;
+    session.GetMapState().ForEachLootItem(0, -1, 10, 1, [&found, near_loot](const collision_detector::Item &item)
+                                          { found += item.id == near_loot; });
+    CHECK(found == 0);
+
+    session.Tick(4s, records);
+    session.FindCollision();
+    CHECK(dog->GetBagSize() == 2);
+
+    session.Tick(3s, records);
+    session.FindCollision();
+    CHECK(dog->GetBagSize() == 0);
+    CHECK(dog->GetScore() == 30);
+}
+
+TEST_CASE("Dog tick on a 10k road map", "[.][benchmark]")
+{
+    constexpr size_t kDogs = 200;
+    const auto map = MakeGridMap();
+    const auto points = RandomPoints(kDogs, kLines * kLineSpacing);
+
+    BENCHMARK("linear scan, 200 lookups")
+    {
+        size_t found = 0;
+        bool found_any = false;
+        for (const auto &point : points)
+        {
+            found += LinearFindRoadAt(map, point, true, found_any) != nullptr;
+        }
+        return found;
+    };
+
+    BENCHMARK("road index, 200 lookups")
+    {
+        size_t found = 0;
+        for (const auto &point : points)
+        {
+            found += map.FindRoadAt(point, true) != nullptr;
+        }
+        return found;
+    };
+
+    model::GameSession session{model::GameSession::Id{"grid"s}, std::make_shared<const model::Map>(MakeGridMap())};
+    const std::string directions[] = {"L"s, "R"s, "U"s, "D"s};
+
+    for (size_t i = 0; i < kDogs; ++i)
+    {
+        auto dog = std::make_shared<model::Dog>(model::Dog::Id{"dog"s + std::to_string(i)});
+        const auto &road = session.GetMap().GetRoads()[(i * 7919) % session.GetMap().GetRoads().size()];
+        dog->SetPosition(road.GetStart().x, road.GetStart().y);
+        dog->SetDirection(directions[i % 4], session.GetMap().GetDogSpeed());
+        session.AddDog(dog);
+    }
+
+    database::RecordWriter records{[](const std::vector<database::PlayerRecord> &) {}};
+
+    BENCHMARK("GameSession::Tick, 200 dogs")
+    {
+        session.Tick(1s, records);
+    };
+
+    BENCHMARK("GameSession::FindCollision, 200 dogs")
+    {
+        session.FindCollision();
+    };
+
+    // Трофей в середине каждой дороги: поиск столкновений смотрит только ячейки вокруг пути собак
+    auto loot_map = MakeGridMap();
+    loot_map.SetBagCapacity(std::numeric_limits<uint32_t>::max());
+
+    model::GameSession loot_session{model::GameSession::Id{"loot"s}, std::make_shared<const model::Map>(std::move(loot_map))};
+    for (const auto &road : loot_session.GetMap().GetRoads())
+    {
+        loot_session.GetMapState().AddLoot(model::MapLoot{0, 1, 0, (road.GetStart().x + road.GetEnd().x) / 2.0, (road.GetStart().y + road.GetEnd().y) / 2.0});
+    }
+    for (size_t i = 0; i < kDogs; ++i)
+    {
+        auto dog = std::make_shared<model::Dog>(model::Dog::Id{"dog"s + std::to_string(i)});
+        const auto &road = loot_session.GetMap().GetRoads()[(i * 7919) % loot_session.GetMap().GetRoads().size()];
+        dog->SetPosition(road.GetStart().x, road.GetStart().y);
+        dog->SetDirection(directions[i % 4], loot_session.GetMap().GetDogSpeed());
+        loot_session.AddDog(dog);
+    }
+
+    BENCHMARK("Tick + FindCollision, 200 dogs, 10k loot")
+    {
+        loot_session.Tick(100ms, records);
+        loot_session.FindCollision();
+    };
+}
@@ -0,0 +1,167 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "../src/slot_map.h"
+#include "../src/model.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace std::literals;
+
+namespace
+{
+    constexpr size_t kLiveItems = 100'000;
+    constexpr size_t kChurnOps = 1'000;
+
+    model::MapLoot MakeLoot(size_t n)
+    {
+        return model::MapLoot{static_cast<int>(n), 1, 0, static_cast<double>(n % 1000), static_cast<double>(n / 1000)};
+    }
+
+    // Прежнее хранение трофеев: вектор с линейным поиском и удалением из середины
+    struct VectorLoots
+    {
+        std::vector<model::MapLoot> loots;
+
+        model::MapLoot *Find(int id)
+        {
+            for (auto &loot : loots)
+            {
+                if (loot.id_ == id)
+                    return &loot;
+            }
+            return nullptr;
+        }
+
+        void Erase(int id)
+        {
+            for (size_t i = 0; i < loots.size(); ++i)
+            {
+                if (loots[i].id_ == id)
+                {
+                    loots.erase(loots.begin() + i);
+                    return;
+                }
+            }
+        }
+    };
+} // namespace
+
+TEST_CASE("SlotMap keeps keys stable while values move", "SlotMap")
+{
+    util::SlotMap<int> slots;
+    const auto a = slots.Insert(1);
+    const auto b = slots.Insert(2);
+    const auto c = slots.Insert(3);
+
+    CHECK(slots.Erase(a));
+    CHECK_FALSE(slots.Erase(a));
+    CHECK(slots.Find(a) == nullptr);
+
+    REQUIRE(slots.Size() == 2);
+    CHECK(*slots.Find(b) == 2);
+    CHECK(*slots.Find(c) == 3);
+
+    // Освободившийся слот переиспользуется с новым поколением
+    const auto d = slots.Insert(4);
+    CHECK(d != a);
+    CHECK(slots.Find(a) == nullptr);
+    CHECK(*slots.Find(d) == 4);
+    CHECK(static_cast<int>(d) >= 0);
+
+    for (size_t i = 0; i < slots.Size(); ++i)
+    {
+        CHECK(*slots.Find(slots.KeyAt(i)) == slots.GetValues()[i]);
+    }
+}
+
+TEST_CASE("SlotMap matches a reference container under random churn", "SlotMap")
+{
+    util::SlotMap<int> slots;
+    std::vector<std::pair<util::SlotMap<int>::Key, int>> expected;
+    std::mt19937 gen{7};
+
+    for (int step = 0; step < 20'000; ++step)
+    {
+        if (expected.empty() || gen() % 3 != 0)
+        {
+            expected.emplace_back(slots.Insert(step), step);
+        }
+        else
+        {
+            const size_t pos = gen() % expected.size();
+            REQUIRE(slots.Erase(expected[pos].first));
+            expected[pos] = expected.back();
+            expected.pop_back();
+        }
+    }
+
+    REQUIRE(slots.Size() == expected.size());
+    for (const auto &[key, value] : expected)
+    {
+        REQUIRE(slots.Find(key) != nullptr);
+        CHECK(*slots.Find(key) == value);
+    }
+}
+
+TEST_CASE("Loot spawn/collect churn at 100k live items", "[.][benchmark]")
+{
+    std::mt19937 gen{42};
+
+    VectorLoots vector_loots;
+    for (size_t i = 0; i < kLiveItems; ++i)
+    {
+        vector_loots.loots.push_back(MakeLoot(i));
+    }
+    int vector_next_id = static_cast<int>(kLiveItems);
+
+    BENCHMARK("vector, 1000 spawn + collect")
+    {
+        for (size_t i = 0; i < kChurnOps; ++i)
+        {
+            const int id = vector_loots.loots[gen() % vector_loots.loots.size()].id_;
+            if (vector_loots.Find(id) != nullptr)
+                vector_loots.Erase(id);
+            vector_loots.loots.push_back(MakeLoot(vector_next_id++));
+        }
+        return vector_loots.loots.size();
+    };
+
+    util::SlotMap<model::MapLoot> slot_loots;
+    for (size_t i = 0; i < kLiveItems; ++i)
+    {
+        slot_loots.Insert(MakeLoot(i));
+    }
+
+    BENCHMARK("SlotMap, 1000 spawn + collect")
+    {
+        for (size_t i = 0; i < kChurnOps; ++i)
+        {
+            const auto key = slot_loots.KeyAt(gen() % slot_loots.Size());
+            if (slot_loots.Find(key) != nullptr)
+                slot_loots.Erase(key);
+            slot_loots.Insert(MakeLoot(i));
+        }
+        return slot_loots.Size();
+    };
+
+    model::MapState map_state;
+    for (size_t i = 0; i < kLiveItems; ++i)
+    {
+        map_state.AddLoot(MakeLoot(i));
+    }
+
+    BENCHMARK("MapState with spatial index, 1000 spawn + collect")
+    {
+        const auto &loots = map_state.GetLoots();
+        for (size_t i = 0; i < kChurnOps; ++i)
+        {
+            const int id = static_cast<int>(loots.KeyAt(gen() % loots.Size()));
+            if (map_state.GetLoot(id) != nullptr)
+                map_state.DeleteItemFromMap(id);
+            map_state.AddLoot(MakeLoot(i));
+        }
+        return loots.Size();
+    };
+}
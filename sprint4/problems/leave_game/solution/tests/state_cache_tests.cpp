@@ -0,0 +1,48 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/state_cache.h"
+
+using namespace std::literals;
+
+TEST_CASE("State body is serialized once per tick", "StateCache")
+{
+    http_handler::StateCache cache;
+    int serialized = 0;
+    auto serialize = [&]
+    {
+        ++serialized;
+        return "state "s + std::to_string(serialized);
+    };
+
+    const auto first = cache.Get(0, 1, 1, serialize);
+    const auto again = cache.Get(0, 1, 1, serialize);
+    CHECK(serialized == 1);
+    CHECK(again->body == first->body);
+    CHECK(again->etag == first->etag);
+
+    // Новый тик или новый игрок в справочнике - новое тело и новая метка
+    const auto next_tick = cache.Get(0, 2, 1, serialize);
+    const auto next_player = cache.Get(0, 2, 2, serialize);
+    CHECK(serialized == 3);
+    CHECK(next_tick->etag != first->etag);
+    CHECK(next_player->etag != next_tick->etag);
+    CHECK(*first->body == "state 1"s);
+
+    // У другой сессии своя ячейка
+    cache.Get(5, 2, 2, serialize);
+    CHECK(serialized == 4);
+    CHECK(cache.GetStats().hits == 1);
+    CHECK(cache.GetStats().misses == 4);
+}
+
+TEST_CASE("If-None-Match accepts lists, weak tags and the wildcard", "StateCache")
+{
+    const auto etag = http_handler::StateCache::MakeETag(1, 2, 3);
+
+    CHECK(http_handler::StateCache::Matches(etag, etag));
+    CHECK(http_handler::StateCache::Matches("\"0-1-1\", " + etag, etag));
+    CHECK(http_handler::StateCache::Matches("W/" + etag, etag));
+    CHECK(http_handler::StateCache::Matches("*"sv, etag));
+    CHECK_FALSE(http_handler::StateCache::Matches(""sv, etag));
+    CHECK_FALSE(http_handler::StateCache::Matches("\"1-2-4\""sv, etag));
+}
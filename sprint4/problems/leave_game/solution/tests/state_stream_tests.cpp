@@ -0,0 +1,190 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/state_stream.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace std::literals;
+
+namespace
+{
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace websocket = beast::websocket;
+    using tcp = net::ip::tcp;
+
+    // Соединённая пара сокетов на loopback: серверный привязан к ioc, клиентский - к client_ioc
+    struct SocketPair
+    {
+        tcp::socket server;
+        tcp::socket client;
+    };
+
+    SocketPair Connect(net::io_context &ioc, net::io_context &client_ioc)
+    {
+        tcp::acceptor acceptor{ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+        tcp::socket client{client_ioc};
+        client.connect(acceptor.local_endpoint());
+        tcp::socket server{ioc};
+        acceptor.accept(server);
+        return {std::move(server), std::move(client)};
+    }
+
+    http::request<http::string_body> ReadUpgrade(tcp::socket &socket)
+    {
+        beast::flat_buffer buffer;
+        http::request<http::string_body> request;
+        http::read(socket, buffer, request);
+        return request;
+    }
+
+    std::string ReadFrame(websocket::stream<tcp::socket> &ws)
+    {
+        beast::flat_buffer buffer;
+        ws.read(buffer);
+        return beast::buffers_to_string(buffer.data());
+    }
+
+    http_handler::StateStreamSession::Frame MakeFrame(std::string text)
+    {
+        return std::make_shared<const std::string>(std::move(text));
+    }
+}
+
+TEST_CASE("Stream keeps only the latest pending frame and sends replies first", "StateStream")
+{
+    net::io_context ioc;
+    net::io_context client_ioc;
+    auto [server_socket, client_socket] = Connect(ioc, client_ioc);
+
+    websocket::stream<tcp::socket> client{std::move(client_socket)};
+    std::vector<std::string> received;
+    beast::error_code close_error;
+    std::thread client_thread{[&]
+                              {
+                                  client.handshake("127.0.0.1", "/api/v1/game/stream");
+                                  received.push_back(ReadFrame(client));
+
+                                  client.write(net::buffer("{\"move\": \"L\"}"sv));
+                                  for (int i = 0; i < 3; ++i)
+                                      received.push_back(ReadFrame(client));
+
+                                  client.write(net::buffer("close"sv));
+                                  beast::flat_buffer buffer;
+                                  client.read(buffer, close_error);
+                              }};
+
+    auto request = ReadUpgrade(server_socket);
+    std::weak_ptr<http_handler::StateStreamSession> weak_session;
+    std::vector<std::string> commands;
+
+    // Обработчик команд выполняется в strand сокета: первый кадр уходит сразу, остальное ждёт конца записи
+    auto session = std::make_shared<http_handler::StateStreamSession>(
+        std::move(server_socket), "token"s, [&](std::string command, http_handler::StateStreamSession::Reply reply)
+        {
+            commands.push_back(command);
+            auto self = weak_session.lock();
+            REQUIRE(self != nullptr);
+            if (command == "close"s)
+                return self->Close();
+
+            self->Push(MakeFrame("tick 4"s));
+            self->Push(MakeFrame("tick 5"s));
+            reply("error"s);
+            self->Push(MakeFrame("tick 6"s));
+        });
+    weak_session = session;
+
+    // До конца рукопожатия кадры только копятся, и ждёт отправки лишь последний
+    session->Push(MakeFrame("tick 1"s));
+    session->Push(MakeFrame("tick 2"s));
+    session->Push(MakeFrame("tick 3"s));
+    session->Run(std::move(request));
+
+    ioc.run_for(10s);
+    client_thread.join();
+
+    CHECK(close_error == websocket::error::closed);
+    REQUIRE(received.size() == 4);
+    CHECK(received[0] == "tick 3"s);
+    CHECK(received[1] == "tick 4"s);
+    CHECK(received[2] == "error"s);
+    CHECK(received[3] == "tick 6"s);
+    CHECK(session->GetDroppedFrames() == 3);
+    CHECK(commands == std::vector{"{\"move\": \"L\"}"s, "close"s});
+    CHECK_FALSE(session->IsOpen());
+}
+
+TEST_CASE("Upgrade with an unknown token is rejected before the handshake", "StateStream")
+{
+    app::Players players;
+    const model::DogHandle handle{0, 0, 1};
+    const auto token = players.AddPlayer("dog"s, app::GameSessionId{"session"s}, handle);
+    const auto directory = players.GetDirectory();
+
+    const auto make_request = [](std::string_view target, std::string_view authorization)
+    {
+        http::request<http::string_body> request{http::verb::get, target, 11};
+        if (!authorization.empty())
+            request.set(http::field::authorization, authorization);
+        return request;
+    };
+
+    auto check = http_handler::StateStream::CheckUpgrade(make_request("/api/v1/game/stream?x=1"sv, "Bearer " + token), *directory);
+    REQUIRE(check.player != nullptr);
+    CHECK(check.player->dog_handle == handle);
+    CHECK(check.token == token);
+
+    check = http_handler::StateStream::CheckUpgrade(make_request("/api/v1/game/other"sv, "Bearer " + token), *directory);
+    CHECK(check.player == nullptr);
+    CHECK(check.status == http::status::not_found);
+
+    check = http_handler::StateStream::CheckUpgrade(make_request("/api/v1/game/stream"sv, ""sv), *directory);
+    CHECK(check.player == nullptr);
+    CHECK(check.status == http::status::unauthorized);
+
+    // Токен ушедшего игрока отклоняется так же, как неизвестный
+    players.DeletePlayer(handle);
+    check = http_handler::StateStream::CheckUpgrade(make_request("/api/v1/game/stream"sv, "Bearer " + token), *players.GetDirectory());
+    CHECK(check.player == nullptr);
+    CHECK(check.status == http::status::unauthorized);
+    CHECK(check.code == "Unknown Token"s);
+
+    // Клиент получает обычный HTTP-ответ вместо рукопожатия
+    net::io_context ioc;
+    net::io_context client_ioc;
+    auto [server_socket, client_socket] = Connect(ioc, client_ioc);
+
+    // Запрос рукопожатия WebSocket с токеном ушедшего игрока
+    auto upgrade = make_request("/api/v1/game/stream"sv, "Bearer " + token);
+    upgrade.set(http::field::host, "127.0.0.1"sv);
+    upgrade.set(http::field::connection, "Upgrade"sv);
+    upgrade.set(http::field::upgrade, "websocket"sv);
+    upgrade.set(http::field::sec_websocket_key, "dGhlIHNhbXBsZSBub25jZQ=="sv);
+    upgrade.set(http::field::sec_websocket_version, "13"sv);
+
+    http::response<http::string_body> response;
+    beast::error_code read_error;
+    std::thread client_thread{[&]
+                              {
+                                  http::write(client_socket, upgrade);
+                                  beast::flat_buffer buffer;
+                                  http::read(client_socket, buffer, response, read_error);
+                              }};
+
+    auto request = ReadUpgrade(server_socket);
+    CHECK(websocket::is_upgrade(request));
+    check = http_handler::StateStream::CheckUpgrade(request, *players.GetDirectory());
+    REQUIRE(check.player == nullptr);
+    http_handler::StateStream::RejectUpgrade(std::move(server_socket), request, check.status, "{\"code\":\"unknownToken\"}"s);
+
+    ioc.run_for(10s);
+    client_thread.join();
+
+    CHECK_FALSE(read_error);
+    CHECK(response.result() == http::status::unauthorized);
+    CHECK_FALSE(response.keep_alive());
+    CHECK(response.body() == "{\"code\":\"unknownToken\"}"s);
+}
@@ -0,0 +1,59 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/ticker.h"
+
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("Fixed step accumulator runs whole steps and drops the excess", "Ticker")
+{
+    app::FixedStepAccumulator accumulator{50ms, 4};
+
+    auto steps = accumulator.Advance(30ms);
+    CHECK(steps.run == 0);
+    CHECK(steps.skipped == 0);
+
+    steps = accumulator.Advance(30ms);
+    CHECK(steps.run == 1);
+    CHECK(accumulator.GetAccumulated() == 10ms);
+
+    // Долгая пауза: догоняются только 4 шага, остальные пропускаются
+    steps = accumulator.Advance(1000ms);
+    CHECK(steps.run == 4);
+    CHECK(steps.skipped == 16);
+    CHECK(accumulator.GetAccumulated() == 10ms);
+}
+
+TEST_CASE("Work after steps runs once per timer firing", "Ticker")
+{
+    boost::asio::io_context ioc;
+    size_t steps = 0;
+    std::vector<std::chrono::milliseconds> firings;
+
+    auto ticker = std::make_shared<app::Ticker>(
+        boost::asio::make_strand(ioc), 10ms,
+        [&](std::chrono::milliseconds delta)
+        {
+            CHECK(delta == 10ms);
+            // Первый шаг задерживает тикер, следующее срабатывание догоняет несколько шагов
+            if (steps++ == 0)
+                std::this_thread::sleep_for(60ms);
+        },
+        5);
+    ticker->SetAfterSteps([&](std::chrono::milliseconds elapsed)
+                          { firings.push_back(elapsed); });
+    ticker->Start();
+    ioc.run_for(300ms);
+
+    REQUIRE(firings.size() >= 2);
+    // Пять догоняющих шагов - одно срабатывание с их суммарной длительностью
+    CHECK(firings[1] == 50ms);
+
+    std::chrono::milliseconds total{0};
+    for (const auto elapsed : firings)
+        total += elapsed;
+    CHECK(total == 10ms * static_cast<int64_t>(steps));
+    CHECK(firings.size() < steps);
+}